@@ -0,0 +1,636 @@
+// rnux-bench: headless micro benchmarks for the matchers and parsers, over generated corpora.
+// everything runs against a throwaway HOME/XDG tree so nothing touches the real ~/.rnux.
+//   rnux-bench [filter]   only runs benchmarks whose name contains filter
+//   rnux-bench --check    runs the self-checks instead, exits non-zero if one fails (ctest runs this)
+#include "harness.h"
+#include "features/app_launcher.h"
+#include "features/calculator.h"
+#include "features/clipboard.h"
+#include "features/fuzzy_scorer.h"
+#include "features/search.h"
+#include "features/system_commands.h"
+#include "features/trigram_index.h"
+#include "features/typo_matcher.h"
+#include "trigger_router.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <optional>
+
+// counted at malloc, not operator new: qt's QString/QList/QByteArray buffers come from QArrayData::allocate,
+// which calls malloc/realloc directly. these replace glibc's for the whole process (qt's libraries too)
+// and hand on to glibc's own entry points. a realloc counts as one allocation of its new size
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* p, std::size_t size);
+void __libc_free(void* p);
+
+void* malloc(const std::size_t size) noexcept {
+    bench::allocations.fetch_add(1, std::memory_order_relaxed);
+    bench::allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(const std::size_t count, const std::size_t size) noexcept {
+    bench::allocations.fetch_add(1, std::memory_order_relaxed);
+    bench::allocatedBytes.fetch_add(count * size, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, const std::size_t size) noexcept {
+    bench::allocations.fetch_add(1, std::memory_order_relaxed);
+    bench::allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+void free(void* p) noexcept {
+    __libc_free(p);
+}
+
+} // extern "C"
+
+// the features are friends with this, it's the only way in to their private matchers and parsers
+struct BenchAccess {
+    static double evaluate(const QString& expression) { return Calculator::evaluateExpression(expression); }
+
+    static QList<FeatureItem> parseNpm(const QJsonDocument& doc) { return Search::parseNpmResults(doc, {}); }
+    static QList<FeatureItem> parseCargo(const QJsonDocument& doc) { return Search::parseCargoResults(doc, {}); }
+    static QList<FeatureItem> parseGitHub(const QJsonDocument& doc) { return Search::parseGitHubResults(doc, {}); }
+
+    static void parseDesktopFiles(const QStringList& paths) {
+        for (const QString& path : paths) {
+            bench::keep(AppLauncher::parseDesktopFile(path));
+        }
+    }
+    static void reloadApplications(AppLauncher& launcher) { launcher.loadApplications(); }
+    static void dropAppIndex() { QFile::remove(AppIndexCache::defaultPath()); }
+    static QList<FeatureItem> applications(const AppLauncher& launcher) { return launcher.catalog()->apps; }
+    static void forgetCandidates(AppLauncher& launcher) { launcher.m_candidates.invalidate(); }
+
+    static void setHistory(Clipboard& clipboard, const QList<ClipboardItem>& history) {
+        clipboard.publishHistory(history);
+    }
+    static void forgetCandidates(Clipboard& clipboard) { clipboard.m_candidates.invalidate(); }
+};
+
+namespace {
+
+constexpr int DESKTOP_FILES = 10000;
+constexpr quint32 SEED = 0x726e7578;
+
+const QStringList WORDS = {
+    "fire", "fox", "term", "inal", "code", "studio", "office", "writer", "calc", "image", "view", "editor",
+    "music", "player", "video", "audio", "mixer", "system", "monitor", "disk", "usage", "network", "manager",
+    "mail", "chat", "steam", "game", "launcher", "photo", "paint", "draw", "note", "book", "reader", "archive",
+    "tool", "settings", "color", "picker", "font", "clock", "weather", "maps", "torrent", "backup", "sync",
+    "virtual", "machine", "docker", "git", "kit", "lab", "box", "shell", "graph", "plot", "scan", "print",
+};
+
+QString randomName(QRandomGenerator& random, const int words) {
+    QStringList parts;
+    for (int i = 0; i < words; ++i) {
+        QString word = WORDS[static_cast<int>(random.bounded(static_cast<quint32>(WORDS.size())))];
+        word[0] = word[0].toUpper();
+        parts.append(word);
+    }
+    return parts.join(' ');
+}
+
+QStringList writeDesktopCorpus(const QString& dirPath) {
+    QDir().mkpath(dirPath);
+    QRandomGenerator random(SEED);
+    QStringList paths;
+    paths.reserve(DESKTOP_FILES);
+
+    for (int i = 0; i < DESKTOP_FILES; ++i) {
+        const QString path = QString("%1/bench-%2.desktop").arg(dirPath).arg(i);
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qFatal("bench ~ could not write %s", qPrintable(path));
+        }
+
+        // roughly what a real install looks like, a few translations, some actions, the odd hidden entry
+        const QString name = randomName(random, 1 + static_cast<int>(random.bounded(3U))) + " " + QString::number(i);
+        QTextStream out(&file);
+        out << "[Desktop Entry]\n"
+            << "Type=Application\n"
+            << "Name=" << name << "\n"
+            << "Name[de]=" << name << " (de)\n"
+            << "Name[fr]=" << name << " (fr)\n"
+            << "GenericName=" << randomName(random, 2) << "\n"
+            << "Comment=" << randomName(random, 5) << "\n"
+            << "Exec=/usr/bin/bench-" << i << " --new %U\n"
+            << "Icon=bench-" << (i % 97) << "\n"
+            << "Categories=Utility;Development;\n"
+            << "Keywords=" << randomName(random, 3).replace(' ', ';') << ";\n";
+        if (i % 50 == 0) {
+            out << "NoDisplay=true\n";
+        }
+        if (i % 10 == 0) {
+            out << "Actions=new-window;\n\n"
+                << "[Desktop Action new-window]\n"
+                << "Name=New Window\n"
+                << "Exec=/usr/bin/bench-" << i << " --new-window\n";
+        }
+        paths.append(path);
+    }
+    return paths;
+}
+
+QList<ClipboardItem> clipboardHistory(const int size) {
+    QRandomGenerator random(SEED + size);
+    QList<ClipboardItem> history;
+    history.reserve(size);
+    const QDateTime now = QDateTime::currentDateTime();
+
+    for (int i = 0; i < size; ++i) {
+        ClipboardItem item;
+        item.type = "text";
+        item.data = randomName(random, 4 + static_cast<int>(random.bounded(40U))).toLower();
+        item.preview = item.data.left(50);
+        item.timestamp = now.addSecs(-i * 37);
+        history.append(item);
+    }
+    return history;
+}
+
+// shaped like the api responses the parsers expect, with the fields they read plus the usual noise around them
+QJsonDocument npmPayload(const int count) {
+    QRandomGenerator random(SEED + 1);
+    QJsonArray objects;
+    for (int i = 0; i < count; ++i) {
+        const QString name = randomName(random, 2).toLower().replace(' ', '-');
+        objects.append(QJsonObject {
+            { "downloads", QJsonObject { { "monthly", static_cast<int>(random.bounded(1000000U)) }, { "weekly", 1234 } } },
+            { "package", QJsonObject {
+                { "name", name },
+                { "version", QString("%1.%2.%3").arg(random.bounded(10U)).arg(random.bounded(20U)).arg(random.bounded(50U)) },
+                { "description", randomName(random, 12) },
+                { "keywords", QJsonArray { "bench", "synthetic", name } },
+                { "links", QJsonObject { { "npm", "https://www.npmjs.com/package/" + name } } },
+            } },
+            { "score", QJsonObject { { "final", 0.5 } } },
+        });
+    }
+    return QJsonDocument(QJsonObject { { "objects", objects }, { "total", count } });
+}
+
+QJsonDocument cargoPayload(const int count) {
+    QRandomGenerator random(SEED + 2);
+    QJsonArray crates;
+    for (int i = 0; i < count; ++i) {
+        crates.append(QJsonObject {
+            { "name", randomName(random, 2).toLower().replace(' ', '_') },
+            { "max_version", "1.0.0" },
+            { "downloads", static_cast<int>(random.bounded(5000000U)) },
+            { "description", randomName(random, 12) },
+            { "repository", "https://github.com/bench/bench" },
+        });
+    }
+    return QJsonDocument(QJsonObject { { "crates", crates }, { "meta", QJsonObject { { "total", count } } } });
+}
+
+QJsonDocument gitHubPayload(const int count) {
+    QRandomGenerator random(SEED + 3);
+    QJsonArray items;
+    for (int i = 0; i < count; ++i) {
+        const QString name = randomName(random, 1).toLower() + "/" + randomName(random, 2).toLower().replace(' ', '-');
+        items.append(QJsonObject {
+            { "full_name", name },
+            { "html_url", "https://github.com/" + name },
+            { "stargazers_count", static_cast<int>(random.bounded(100000U)) },
+            { "description", randomName(random, 12) },
+            { "owner", QJsonObject { { "login", name.section('/', 0, 0) }, { "type", "User" } } },
+        });
+    }
+    return QJsonDocument(QJsonObject { { "items", items }, { "total_count", count } });
+}
+
+// what AppLauncher::search did per title before FuzzyIndex, kept as the baseline its rows are read
+// against: lowercase the title on every keystroke, then a greedy scalar scan
+int baselineFuzzyMatch(const QString& lowerQuery, const QString& title) {
+    const QString text = title.toLower();
+    if (lowerQuery.isEmpty()) return 1;
+    if (text.isEmpty()) return 0;
+
+    int score = 0;
+    int queryPos = 0;
+    int lastMatchIndex = -1;
+    for (int i = 0; i < text.length() && queryPos < lowerQuery.length(); ++i) {
+        if (text[i] == lowerQuery[queryPos]) {
+            int currentScore = 1;
+            if (lastMatchIndex == -1) currentScore += 10;
+            if (lastMatchIndex == i - 1) currentScore += 5;
+            if (i == 0 || text[i - 1].isSpace()) currentScore += 8;
+            score += currentScore;
+            lastMatchIndex = i;
+            queryPos++;
+        }
+    }
+    return queryPos == lowerQuery.length() ? score : 0;
+}
+
+QueryContext contextFor(const QString& query, const QString& trigger = {}, const QString& argument = {}) {
+    QueryContext context;
+    context.query = query;
+    context.trigger = trigger;
+    context.argument = argument;
+    return context;
+}
+
+// every way query can be laid over folded, scored one by one. the dp in FuzzyScorer::score keeps only
+// one path per cell, so it can come out a little under this, never over
+std::optional<int> bruteForceScore(const QString& text, const QString& folded, const QString& query, QList<int>& positions) {
+    if (positions.size() == query.size()) {
+        return FuzzyScorer::alignmentScore(text, folded, positions.constData(), positions.size());
+    }
+    std::optional<int> best;
+    for (int j = positions.isEmpty() ? 0 : positions.last() + 1; j < folded.size(); ++j) {
+        if (folded[j] != query[positions.size()]) {
+            continue;
+        }
+        positions.append(j);
+        if (const auto score = bruteForceScore(text, folded, query, positions); score && (!best || *score > *best)) {
+            best = score;
+        }
+        positions.removeLast();
+    }
+    return best;
+}
+
+QString randomString(QRandomGenerator& random, const QString& alphabet, const int minLength, const int maxLength) {
+    QString text;
+    const int length = minLength + static_cast<int>(random.bounded(static_cast<quint32>(maxLength - minLength + 1)));
+    for (int i = 0; i < length; ++i) {
+        text.append(alphabet[static_cast<int>(random.bounded(static_cast<quint32>(alphabet.size())))]);
+    }
+    return text;
+}
+
+void checkScorer() {
+    QRandomGenerator random(SEED);
+    int cases = 0;
+    int under = 0;
+    for (int n = 0; n < 50000; ++n) {
+        const QString text = randomString(random, "abAB _-1", 1, 14);
+        const QString folded = text.toLower();
+        const QString query = randomString(random, "ab _1", 1, 4);
+        int positions[4];
+        const auto score = FuzzyScorer::score(text, folded, query, positions);
+        QList<int> path;
+        const auto best = bruteForceScore(text, folded, query, path);
+
+        const QString what = QString("FuzzyScorer::score \"%1\" in \"%2\"").arg(query, text);
+        bench::expect(score.has_value() == best.has_value(), what + " finds a match iff one exists");
+        if (!score || !best) {
+            continue;
+        }
+        ++cases;
+        bool aligned = true;
+        for (qsizetype i = 0; i < query.size(); ++i) {
+            aligned = aligned && folded[positions[i]] == query[i] && (i == 0 || positions[i] > positions[i - 1]);
+        }
+        bench::expect(aligned, what + " positions spell the query");
+        bench::expect(*score == FuzzyScorer::alignmentScore(text, folded, positions, query.size()), what + " scores its own positions");
+        bench::expect(*score <= *best, what + " never beats brute force");
+        under += *score < *best;
+    }
+    // the dp dropping a path that would have won later, fzf has the same blind spot
+    bench::expect(under * 100 < cases, QString("FuzzyScorer::score under brute force in %1 of %2 cases").arg(under).arg(cases));
+}
+
+
+// plain O(nm) optimal string alignment with the query free to start and end anywhere in text
+int bruteForceTypos(const QString& query, const QString& text) {
+    const qsizetype m = query.size();
+    const qsizetype n = text.size();
+    QList<QList<int>> d(m + 1, QList<int>(n + 1, 0));
+    for (qsizetype i = 1; i <= m; ++i) {
+        d[i][0] = static_cast<int>(i);
+        for (qsizetype j = 1; j <= n; ++j) {
+            d[i][j] = std::min({ d[i - 1][j] + 1, d[i][j - 1] + 1, d[i - 1][j - 1] + (query[i - 1] != text[j - 1]) });
+            if (i > 1 && j > 1 && query[i - 1] == text[j - 2] && query[i - 2] == text[j - 1]) {
+                d[i][j] = std::min(d[i][j], d[i - 2][j - 2] + 1);
+            }
+        }
+    }
+    return *std::min_element(d[m].cbegin(), d[m].cend());
+}
+
+void checkTypos() {
+    QRandomGenerator random(SEED + 1);
+    for (int n = 0; n < 20000; ++n) {
+        // a small alphabet so swaps and near misses come up all the time, é for the non-ascii patterns
+        const QString query = randomString(random, "abcdé", 1, 10);
+        const QString text = randomString(random, "abcdé ", 0, 20);
+        const TypoMatcher matcher(query);
+        const int expected = bruteForceTypos(query, text);
+        for (int limit = 0; limit <= 3; ++limit) {
+            bench::expect(matcher.distance(text, limit) == std::min(expected, limit + 1),
+                          QString("TypoMatcher::distance \"%1\" in \"%2\" limit %3").arg(query, text).arg(limit));
+        }
+    }
+
+    // what AppLauncher::appendTypoMatches finds through the mask bound has to be what a full scan finds
+    QStringList titles;
+    for (int n = 0; n < 2000; ++n) {
+        titles.append(randomString(random, "abcdefgh ", 3, 24));
+    }
+    const FuzzyIndex index(titles);
+    for (int n = 0; n < 200; ++n) {
+        const FuzzyIndex::Query prepared = FuzzyIndex::prepare(randomString(random, "abcdefgh", 4, 10));
+        const TypoMatcher matcher(prepared.folded);
+        const int allowed = TypoMatcher::allowedTypos(prepared.folded.size());
+        QList<int> bounded;
+        QList<int> scanned;
+        for (qsizetype i = 0; i < index.size(); ++i) {
+            if (index.missing(i, prepared) <= allowed && matcher.distance(index.text(i), allowed) <= allowed) {
+                bounded.append(static_cast<int>(i));
+            }
+            if (bruteForceTypos(prepared.folded, titles[i]) <= allowed) {
+                scanned.append(static_cast<int>(i));
+            }
+        }
+        bench::expect(bounded == scanned, QString("typo candidates for \"%1\" match a full scan").arg(prepared.folded));
+    }
+}
+
+// the postings only narrow, what survives the substring check has to be exactly what scanning every
+// document finds
+void checkTrigrams() {
+    QRandomGenerator random(SEED + 2);
+    QList<TrigramIndex::Fields> documents;
+    for (int n = 0; n < 3000; ++n) {
+        TrigramIndex::Fields fields;
+        for (QString& field : fields) {
+            field = randomString(random, "abcdeABC ", 0, 16);
+        }
+        documents.append(fields);
+    }
+    const TrigramIndex index(documents);
+
+    for (int n = 0; n < 500; ++n) {
+        const QString token = randomString(random, "abcde", 3, 5);
+        QList<int> scanned;
+        for (qsizetype d = 0; d < documents.size(); ++d) {
+            if (std::any_of(documents[d].cbegin(), documents[d].cend(), [&token](const QString& field) {
+                    return field.toLower().contains(token);
+                })) {
+                scanned.append(static_cast<int>(d));
+            }
+        }
+        QList<int> narrowed;
+        for (const int d : index.candidates(token)) {
+            if (index.fieldScore(d, token) > 0.0) {
+                narrowed.append(d);
+            }
+        }
+        bench::expect(narrowed == scanned, QString("trigram candidates for \"%1\" match a full scan").arg(token));
+    }
+
+    for (int n = 0; n < 500; ++n) {
+        QList<int> a;
+        QList<int> b;
+        for (int v = 0; v < 400; ++v) {
+            if (random.bounded(4U) == 0) a.append(v);
+            if (random.bounded(9U) == 0) b.append(v);
+        }
+        QList<int> expected;
+        std::set_intersection(a.cbegin(), a.cend(), b.cbegin(), b.cend(), std::back_inserter(expected));
+        bench::expect(TrigramIndex::intersect(a, b) == expected, "TrigramIndex::intersect matches std::set_intersection");
+    }
+}
+
+// a search shortcut that is also a common word still has to reach the apps, only "clip" keeps its
+// queries to itself
+void checkRouting() {
+    AppLauncher launcher;
+    SystemCommands systemCommands;
+    Search search;
+    Clipboard clipboard;
+    TriggerRouter router;
+    router.setFeatures({ &launcher, &systemCommands, &search, &clipboard });
+
+    const auto route = [&router](const QString& query) {
+        QueryContext context = contextFor(query);
+        const QList<FeatureBase*> routed = router.route(context);
+        return std::pair(context, routed);
+    };
+
+    for (const QString query : { "docker desktop", "yandex browser", "wiki", "so" }) {
+        const auto [context, routed] = route(query);
+        bench::expect(routed.contains(&launcher), QString("\"%1\" reaches AppLauncher").arg(query));
+        bench::expect(!routed.contains(&clipboard), QString("\"%1\" stays out of Clipboard").arg(query));
+    }
+
+    const auto [docker, dockerRouted] = route("docker desktop");
+    bench::expect(dockerRouted.contains(&search), "\"docker desktop\" reaches Search");
+    const QueryContext forSearch = router.contextFor(&search, docker);
+    bench::expect(forSearch.trigger == "docker" && forSearch.argument == "desktop", "Search gets docker's trigger and argument");
+    const QueryContext forApps = router.contextFor(&launcher, docker);
+    bench::expect(forApps.trigger.isEmpty() && forApps.argument.isEmpty(), "AppLauncher gets the plain query");
+
+    const auto [clip, clipRouted] = route("clip foo");
+    bench::expect(clipRouted == QList<FeatureBase*> { &clipboard }, "\"clip foo\" only reaches Clipboard");
+
+    const auto [plain, plainRouted] = route("firefox");
+    bench::expect(plainRouted.contains(&launcher) && !plainRouted.contains(&search) && !plainRouted.contains(&clipboard),
+                  "\"firefox\" reaches the general features only");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // point every path the features use into a temp tree before qt caches any of them
+    QTemporaryDir root;
+    if (!root.isValid()) {
+        qFatal("bench ~ no temp dir");
+    }
+    qputenv("HOME", root.filePath("home").toUtf8());
+    qputenv("XDG_DATA_HOME", root.filePath("home/.local/share").toUtf8());
+    qputenv("XDG_CONFIG_HOME", root.filePath("home/.config").toUtf8());
+    qputenv("XDG_CACHE_HOME", root.filePath("home/.cache").toUtf8());
+    qputenv("XDG_DATA_DIRS", root.filePath("share").toUtf8());
+    // the features' debug logging would end up between the table rows
+    qputenv("QT_LOGGING_RULES", "*.debug=false");
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    const QStringList desktopFiles = writeDesktopCorpus(root.filePath("share/applications"));
+
+    const QGuiApplication app(argc, argv);
+    if (argc > 1 && qstrcmp(argv[1], "--check") == 0) {
+        checkRouting();
+        checkScorer();
+        checkTypos();
+        checkTrigrams();
+        std::printf("%d failed\n", bench::failures);
+        return bench::failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    const QString filter = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString();
+    const auto run = [&filter](const QString& name, const std::function<void()>& op, const qint64 itemsPerOp = 1) {
+        if (filter.isEmpty() || name.contains(filter, Qt::CaseInsensitive)) {
+            bench::print(name, bench::measure(op, itemsPerOp));
+        }
+    };
+
+    bench::printHeader();
+
+    // app launcher
+    AppLauncher launcher;
+    launcher.initialize();
+    QStringList titles;
+    QStringList originalTitles;
+    for (const FeatureItem& app : BenchAccess::applications(launcher)) {
+        titles.append(app.title.toLower());
+        originalTitles.append(app.title);
+    }
+
+    run("AppLauncher::parseDesktopFile (per file)", [&]() {
+        BenchAccess::parseDesktopFiles(desktopFiles);
+    }, DESKTOP_FILES);
+    run("AppLauncher::loadApplications cold (10k files, per file)", [&]() {
+        BenchAccess::dropAppIndex();
+        BenchAccess::reloadApplications(launcher);
+    }, DESKTOP_FILES);
+    run("AppLauncher::loadApplications from index (10k files, per file)", [&]() {
+        BenchAccess::reloadApplications(launcher);
+    }, DESKTOP_FILES);
+
+    for (const QString query : { "f", "fire", "tlbx", "zzzz" }) {
+        run(QString("baseline toLower + greedy loop \"%1\" (per title)").arg(query), [&]() {
+            int total = 0;
+            for (const QString& title : originalTitles) {
+                total += baselineFuzzyMatch(query, title);
+            }
+            bench::keep(total);
+        }, originalTitles.size());
+    }
+
+    // what AppLauncher::search does per title: the mask check, then the simd scan for the survivors
+    const FuzzyIndex titleIndex(titles);
+    for (const QString query : { "f", "fire", "tlbx", "zzzz" }) {
+        const FuzzyIndex::Query prepared = FuzzyIndex::prepare(query);
+        QList<int> positions(prepared.folded.size());
+        run(QString("FuzzyIndex::subsequence \"%1\" (per title, %2)").arg(query, QString(FuzzyIndex::kernel())), [&]() {
+            int total = 0;
+            for (qsizetype i = 0; i < titleIndex.size(); ++i) {
+                total += titleIndex.subsequence(i, prepared, positions.data());
+            }
+            bench::keep(total);
+        }, titleIndex.size());
+    }
+
+    // and the scorer, which only gets the titles that passed that
+    for (const QString query : { "f", "fire", "tlbx" }) {
+        const FuzzyIndex::Query prepared = FuzzyIndex::prepare(query);
+        QList<int> positions(prepared.folded.size());
+        run(QString("FuzzyScorer::score \"%1\" (per title)").arg(query), [&]() {
+            int total = 0;
+            for (const QString& title : titles) {
+                total += FuzzyScorer::score(title, title, prepared.folded, positions.data()).value_or(0);
+            }
+            bench::keep(total);
+        }, titles.size());
+    }
+
+    // the typo fallback: mask bound first, then the bit-parallel distance for what's left
+    for (const QString query : { "firfox", "thunderbrid", "zzzzzz" }) {
+        const FuzzyIndex::Query prepared = FuzzyIndex::prepare(query);
+        const TypoMatcher matcher(prepared.folded);
+        const int allowed = TypoMatcher::allowedTypos(prepared.folded.size());
+        run(QString("TypoMatcher::distance \"%1\" (per title)").arg(query), [&]() {
+            int total = 0;
+            for (qsizetype i = 0; i < titleIndex.size(); ++i) {
+                if (titleIndex.missing(i, prepared) <= allowed) {
+                    total += matcher.distance(titleIndex.text(i), allowed);
+                }
+            }
+            bench::keep(total);
+        }, titleIndex.size());
+    }
+
+    for (const QString query : { "f", "fire", "firefox term", "firfox", "utility devel", "new window" }) {
+        const QueryContext context = contextFor(query);
+        run(QString("AppLauncher::search \"%1\" (cold)").arg(query), [&]() {
+            BenchAccess::forgetCandidates(launcher);
+            bench::keep(launcher.search(context));
+        });
+    }
+    run("AppLauncher::search f,fi,fir,fire (narrowing)", [&]() {
+        BenchAccess::forgetCandidates(launcher);
+        for (const QString query : { "f", "fi", "fir", "fire" }) {
+            bench::keep(launcher.search(contextFor(query)));
+        }
+    }, 4);
+
+    // system commands
+    SystemCommands systemCommands;
+    for (const QString query : { "s", "lock", "fm" }) {
+        const QueryContext context = contextFor(query);
+        run(QString("SystemCommands::search \"%1\"").arg(query), [&]() {
+            bench::keep(systemCommands.search(context));
+        });
+    }
+
+    // clipboard
+    Clipboard clipboard;
+    for (const int size : { 500, 5000 }) {
+        BenchAccess::setHistory(clipboard, clipboardHistory(size));
+        for (const QString argument : { "", "fire", "zzzz" }) {
+            const QueryContext context = contextFor("clip " + argument, "clip", argument);
+            run(QString("Clipboard::search %1 items \"%2\" (cold)").arg(size).arg(argument), [&]() {
+                BenchAccess::forgetCandidates(clipboard);
+                bench::keep(clipboard.search(context));
+            });
+        }
+    }
+    BenchAccess::setHistory(clipboard, {});
+
+    // calculator
+    QString longExpression = "1";
+    for (int i = 2; i <= 200; ++i) {
+        longExpression += QString(i % 3 ? "+%1" : "*(%1-1)").arg(i);
+    }
+    for (const QString expression : { QString("1+2"), QString("(3.5*4-2)/7+12*(8-3)"), longExpression }) {
+        run(QString("Calculator::evaluateExpression %1 chars").arg(expression.size()), [&]() {
+            bench::keep(BenchAccess::evaluate(expression));
+        });
+    }
+
+    // search api parsers, 10 is what the providers return per page
+    for (const int count : { 10, 100 }) {
+        const QJsonDocument npm = npmPayload(count);
+        const QJsonDocument cargo = cargoPayload(count);
+        const QJsonDocument gitHub = gitHubPayload(count);
+        const QByteArray npmJson = npm.toJson(QJsonDocument::Compact);
+
+        run(QString("Search::parseNpmResults %1 (per result)").arg(count), [&]() {
+            bench::keep(BenchAccess::parseNpm(npm));
+        }, count);
+        run(QString("Search npm fromJson+parse %1 (per result)").arg(count), [&]() {
+            bench::keep(BenchAccess::parseNpm(QJsonDocument::fromJson(npmJson)));
+        }, count);
+        run(QString("Search::parseCargoResults %1 (per result)").arg(count), [&]() {
+            bench::keep(BenchAccess::parseCargo(cargo));
+        }, count);
+        run(QString("Search::parseGitHubResults %1 (per result)").arg(count), [&]() {
+            bench::keep(BenchAccess::parseGitHub(gitHub));
+        }, count);
+    }
+
+    return 0;
+}
\ No newline at end of file
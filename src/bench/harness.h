@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QString>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+namespace bench {
+
+// bumped by the malloc/calloc/realloc in bench.cpp, which qt's containers and std's operator new both
+// end up in. memory from aligned_alloc/posix_memalign (over-aligned new) isnt counted
+inline std::atomic<quint64> allocations { 0 };
+inline std::atomic<quint64> allocatedBytes { 0 };
+
+// rnux-bench --check runs the self-checks instead of the benchmarks, every failed expect() is counted here
+inline int failures = 0;
+
+inline void expect(const bool ok, const QString& what) {
+    if (!ok) {
+        ++failures;
+        std::fprintf(stderr, "FAIL %s\n", qPrintable(what));
+    }
+}
+
+// keeps the compiler from throwing away a result nobody reads
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Result {
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+    qint64 iterations;
+};
+
+// runs op in growing batches until one batch takes MIN_BATCH_NS and reports that batch.
+// itemsPerOp splits the numbers further, eg. one op parsing 10k files reports per file
+template <typename Op>
+Result measure(Op&& op, const qint64 itemsPerOp = 1) {
+    constexpr qint64 MIN_BATCH_NS = 200'000'000;
+    op(); // lazy statics, caches, first touch of the corpus
+
+    qint64 iterations = 1;
+    for (;;) {
+        const quint64 allocsBefore = allocations.load(std::memory_order_relaxed);
+        const quint64 bytesBefore = allocatedBytes.load(std::memory_order_relaxed);
+        QElapsedTimer timer;
+        timer.start();
+        for (qint64 i = 0; i < iterations; ++i) {
+            op();
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+
+        if (elapsed >= MIN_BATCH_NS || iterations >= (qint64(1) << 32)) {
+            const auto ops = static_cast<double>(iterations * itemsPerOp);
+            return {
+                static_cast<double>(elapsed) / ops,
+                static_cast<double>(allocations.load(std::memory_order_relaxed) - allocsBefore) / ops,
+                static_cast<double>(allocatedBytes.load(std::memory_order_relaxed) - bytesBefore) / ops,
+                iterations,
+            };
+        }
+
+        // aim a bit past the target so the next batch is usually the last one
+        const double scale = 1.2 * MIN_BATCH_NS / static_cast<double>(std::max<qint64>(elapsed, 1));
+        iterations = std::clamp(static_cast<qint64>(static_cast<double>(iterations) * scale), iterations * 2, iterations * 100);
+    }
+}
+
+inline void printHeader() {
+    std::printf("%-52s %12s %10s %12s %10s\n", "benchmark", "ns/op", "allocs/op", "bytes/op", "iters");
+}
+
+inline void print(const QString& name, const Result& result) {
+    std::printf("%-52s %12.1f %10.2f %12.1f %10lld\n", qPrintable(name), result.nsPerOp, result.allocsPerOp,
+                result.bytesPerOp, static_cast<long long>(result.iterations));
+    std::fflush(stdout);
+}
+
+} // namespace bench
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "app_index_cache.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+#include <sys/stat.h>
+
+AppIndexCache::AppIndexCache(const QString& path, const QByteArray& locale)
+    : m_file(path)
+{
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    m_size = m_file.size();
+    if (m_size < static_cast<qint64>(sizeof(Header))) {
+        return;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (m_data && !validate()) {
+        qDebug() << "apps ~ ignoring outdated or damaged" << path;
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    } else if (m_data && string(header()->locale) != QString::fromLatin1(locale)) {
+        // every name in there is in the old language, and no stamp would tell
+        qDebug() << "apps ~ ignoring" << path << "written for locale" << string(header()->locale);
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    }
+}
+
+AppIndexCache::~AppIndexCache() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+}
+
+bool AppIndexCache::validate() const {
+    const Header* head = header();
+    if (std::memcmp(head->magic, "RNXA", 4) != 0 || head->version != VERSION) {
+        return false;
+    }
+
+    const qint64 expected = static_cast<qint64>(sizeof(Header))
+        + static_cast<qint64>(head->dirCount) * static_cast<qint64>(sizeof(DirRecord))
+        + static_cast<qint64>(head->fileCount) * static_cast<qint64>(sizeof(FileRecord))
+        + static_cast<qint64>(head->actionCount) * static_cast<qint64>(sizeof(ActionRecord))
+        + static_cast<qint64>(head->stringUnits) * 2;
+    if (expected != m_size) {
+        return false;
+    }
+
+    // everything gets checked once here so the accessors can trust the offsets
+    const auto inPool = [head](const StringRef& ref) {
+        return ref.offset <= head->stringUnits && ref.length <= head->stringUnits - ref.offset;
+    };
+    if (!inPool(head->locale)) {
+        return false;
+    }
+    quint32 nextFile = 0;
+    for (quint32 i = 0; i < head->dirCount; ++i) {
+        const DirRecord& dir = dirs()[i];
+        if (!inPool(dir.path) || dir.firstFile != nextFile || dir.fileCount > head->fileCount - nextFile) {
+            return false;
+        }
+        nextFile += dir.fileCount;
+    }
+    if (nextFile != head->fileCount) {
+        return false;
+    }
+    quint32 nextAction = 0;
+    for (quint32 i = 0; i < head->fileCount; ++i) {
+        const FileRecord& file = files()[i];
+        for (const StringRef& ref : { file.name, file.title, file.genericName, file.comment, file.icon, file.exec,
+                                      file.keywords, file.categories }) {
+            if (!inPool(ref)) {
+                return false;
+            }
+        }
+        if (file.firstAction != nextAction || file.actionCount > head->actionCount - nextAction) {
+            return false;
+        }
+        nextAction += file.actionCount;
+    }
+    if (nextAction != head->actionCount) {
+        return false;
+    }
+    for (quint32 i = 0; i < head->actionCount; ++i) {
+        const ActionRecord& action = actions()[i];
+        if (!inPool(action.id) || !inPool(action.name) || !inPool(action.icon) || !inPool(action.exec)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int AppIndexCache::dirCount() const {
+    return m_data ? static_cast<int>(header()->dirCount) : 0;
+}
+
+int AppIndexCache::findDir(const QString& path) const {
+    for (int i = 0; i < dirCount(); ++i) {
+        if (string(dirs()[i].path) == path) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+AppIndexCache::Stamp AppIndexCache::dirStamp(const int dir) const {
+    return { dirs()[dir].mtime, dirs()[dir].size };
+}
+
+QPair<int, int> AppIndexCache::dirFiles(const int dir) const {
+    return { static_cast<int>(dirs()[dir].firstFile), static_cast<int>(dirs()[dir].fileCount) };
+}
+
+QString AppIndexCache::fileName(const int file) const {
+    return string(files()[file].name);
+}
+
+AppIndexCache::Stamp AppIndexCache::fileStamp(const int file) const {
+    return { files()[file].mtime, files()[file].size };
+}
+
+std::optional<DesktopEntry> AppIndexCache::entry(const int file) const {
+    const FileRecord& record = files()[file];
+    if (!(record.flags & IS_APP)) {
+        return std::nullopt;
+    }
+    const auto list = [this](const StringRef& ref) {
+        return ref.length == 0 ? QStringList() : string(ref).split(LIST_SEPARATOR);
+    };
+    DesktopEntry entry;
+    entry.name = string(record.title);
+    entry.genericName = string(record.genericName);
+    entry.comment = string(record.comment);
+    entry.icon = string(record.icon);
+    entry.exec = string(record.exec);
+    entry.keywords = list(record.keywords);
+    entry.categories = list(record.categories);
+    for (quint32 i = record.firstAction; i < record.firstAction + record.actionCount; ++i) {
+        const ActionRecord& action = actions()[i];
+        entry.actions.append({ string(action.id), string(action.name), string(action.icon), string(action.exec) });
+    }
+    return entry;
+}
+
+AppIndexCache::Dir AppIndexCache::dir(const int index) const {
+    Dir dir { string(dirs()[index].path), dirStamp(index), {} };
+    const auto [first, count] = dirFiles(index);
+    dir.files.reserve(count);
+    for (int file = first; file < first + count; ++file) {
+        dir.files.append({ fileName(file), fileStamp(file), entry(file) });
+    }
+    return dir;
+}
+
+QString AppIndexCache::string(const StringRef& ref) const {
+    return QString(reinterpret_cast<const QChar*>(strings() + ref.offset), ref.length);
+}
+
+AppIndexCache::Stamp AppIndexCache::stampOf(const QString& path) {
+    // plain stat, QFileInfo does a lot more than this per file
+    struct stat info {};
+    if (::stat(QFile::encodeName(path).constData(), &info) != 0) {
+        return {};
+    }
+    return { static_cast<qint64>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec, static_cast<qint64>(info.st_size) };
+}
+
+QString AppIndexCache::defaultPath() {
+    return QStandardPaths::writableLocation(QStandardPaths::HomeLocation) + "/.rnux/apps.idx";
+}
+
+AppIndexCache::Writer::Writer(const QByteArray& locale) {
+    // first thing in the pool, m_strings has to exist before addString can go
+    m_locale = addString(QString::fromLatin1(locale));
+}
+
+void AppIndexCache::Writer::beginDir(const QString& path, const Stamp& stamp) {
+    DirRecord record {};
+    record.mtime = stamp.mtime;
+    record.size = stamp.size;
+    const auto [offset, length] = addString(path);
+    record.path = { offset, length };
+    record.firstFile = m_fileCount;
+    record.fileCount = 0;
+    m_dirs.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    m_dirCount++;
+}
+
+void AppIndexCache::Writer::addFile(const QString& name, const Stamp& stamp, const std::optional<DesktopEntry>& entry) {
+    Q_ASSERT(m_dirCount > 0);
+
+    FileRecord record {};
+    record.mtime = stamp.mtime;
+    record.size = stamp.size;
+    const auto ref = [this](const QString& text) {
+        const auto [offset, length] = addString(text);
+        return StringRef { offset, length };
+    };
+    record.name = ref(name);
+    if (entry) {
+        record.flags = IS_APP;
+        record.title = ref(entry->name);
+        record.genericName = ref(entry->genericName);
+        record.comment = ref(entry->comment);
+        record.icon = ref(entry->icon);
+        record.exec = ref(entry->exec);
+        record.keywords = ref(entry->keywords.join(LIST_SEPARATOR));
+        record.categories = ref(entry->categories.join(LIST_SEPARATOR));
+        for (const DesktopAction& action : entry->actions) {
+            const ActionRecord actionRecord { ref(action.id), ref(action.name), ref(action.icon), ref(action.exec) };
+            m_actions.append(reinterpret_cast<const char*>(&actionRecord), sizeof(actionRecord));
+        }
+        record.actionCount = static_cast<quint32>(entry->actions.size());
+    }
+    record.firstAction = m_actionCount;
+    m_actionCount += record.actionCount;
+    m_files.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    m_fileCount++;
+
+    auto* dir = reinterpret_cast<DirRecord*>(m_dirs.data() + m_dirs.size() - sizeof(DirRecord));
+    dir->fileCount++;
+}
+
+QPair<quint32, quint32> AppIndexCache::Writer::addString(const QString& text) {
+    const auto offset = static_cast<quint32>(m_strings.size());
+    m_strings.append(text);
+    return { offset, static_cast<quint32>(text.size()) };
+}
+
+bool AppIndexCache::Writer::save(const QString& path) const {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    Header head {};
+    std::memcpy(head.magic, "RNXA", 4);
+    head.version = VERSION;
+    head.dirCount = m_dirCount;
+    head.fileCount = m_fileCount;
+    head.stringUnits = static_cast<quint32>(m_strings.size());
+    head.actionCount = m_actionCount;
+    head.locale = { m_locale.first, m_locale.second };
+
+    // written next to the old one and renamed over it, a start that still has the old one mapped keeps reading that
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "apps ~ could not write" << path;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&head), sizeof(head));
+    file.write(m_dirs);
+    file.write(m_files);
+    file.write(m_actions);
+    file.write(reinterpret_cast<const char*>(m_strings.constData()), m_strings.size() * 2);
+    return file.commit();
+}
\ No newline at end of file
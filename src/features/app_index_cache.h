@@ -0,0 +1,160 @@
+#pragma once
+
+#include <QFile>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <optional>
+
+#include "desktop_entry.h"
+
+// the parsed .desktop entries from the last start, memory mapped from ~/.rnux/apps.idx.
+// every file is stored with the mtime/size it had when it was parsed and every dir with its mtime,
+// so a start is one mmap and a stat per file, and only the files that changed go through the parser.
+// names and comments are the localized ones, an index written for another locale is thrown away whole.
+// layout: Header | DirRecord[dirCount] | FileRecord[fileCount] | ActionRecord[actionCount] | utf-16 string pool
+class AppIndexCache {
+public:
+    // what a file looked like when it was parsed, mtime -1 if it couldnt be stat'd
+    struct Stamp {
+        qint64 mtime { -1 }; // ns
+        qint64 size { -1 };
+
+        bool operator==(const Stamp& other) const { return mtime == other.mtime && size == other.size; }
+        bool operator!=(const Stamp& other) const { return !(*this == other); }
+        [[nodiscard]] bool exists() const { return mtime >= 0; }
+    };
+
+    struct File {
+        QString name; // inside its dir
+        Stamp stamp;
+        std::optional<DesktopEntry> entry; // empty for files that arent listed (hidden, not an application)
+    };
+
+    struct Dir {
+        QString path;
+        Stamp stamp; // a missing dir is kept with an empty stamp and no files
+        QList<File> files;
+    };
+
+    // builds the next version of the index in memory, save() replaces the file in one go
+    class Writer {
+    public:
+        // locale is what the entries were parsed for
+        explicit Writer(const QByteArray& locale = DesktopEntryParser::systemLocale());
+
+        void beginDir(const QString& path, const Stamp& stamp);
+        // entry is empty for files that arent listed (hidden, not an application), they still get remembered
+        void addFile(const QString& name, const Stamp& stamp, const std::optional<DesktopEntry>& entry);
+        bool save(const QString& path) const;
+
+    private:
+        [[nodiscard]] QPair<quint32, quint32> addString(const QString& text);
+
+        QPair<quint32, quint32> m_locale;
+        QByteArray m_dirs;
+        QByteArray m_files;
+        QByteArray m_actions;
+        QString m_strings;
+        quint32 m_dirCount { 0 };
+        quint32 m_fileCount { 0 };
+        quint32 m_actionCount { 0 };
+    };
+
+    // maps path if it's there, an unreadable or outdated file (or one parsed for another locale) just
+    // means an empty cache
+    explicit AppIndexCache(const QString& path, const QByteArray& locale = DesktopEntryParser::systemLocale());
+    ~AppIndexCache();
+
+    AppIndexCache(const AppIndexCache&) = delete;
+    AppIndexCache& operator=(const AppIndexCache&) = delete;
+
+    [[nodiscard]] bool isValid() const { return m_data != nullptr; }
+    [[nodiscard]] int dirCount() const;
+    // -1 if the dir wasnt there last time
+    [[nodiscard]] int findDir(const QString& path) const;
+    [[nodiscard]] Stamp dirStamp(int dir) const;
+    // files of a dir are stored next to each other, [first, first + count)
+    [[nodiscard]] QPair<int, int> dirFiles(int dir) const;
+    [[nodiscard]] QString fileName(int file) const;
+    [[nodiscard]] Stamp fileStamp(int file) const;
+    [[nodiscard]] std::optional<DesktopEntry> entry(int file) const;
+    // copies a whole dir out of the mapping
+    [[nodiscard]] Dir dir(int index) const;
+
+    static Stamp stampOf(const QString& path);
+    static QString defaultPath();
+
+    // has to go up whenever the parser starts reading something else out of .desktop files
+    static constexpr quint32 VERSION = 5;
+
+private:
+    struct StringRef {
+        quint32 offset;
+        quint32 length;
+    };
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 dirCount;
+        quint32 fileCount;
+        quint32 stringUnits; // char16_t, not bytes
+        quint32 actionCount;
+        StringRef locale; // DesktopEntryParser::systemLocale() the entries were parsed for
+    };
+
+    struct DirRecord {
+        qint64 mtime;
+        qint64 size;
+        StringRef path;
+        quint32 firstFile;
+        quint32 fileCount;
+    };
+
+    struct FileRecord {
+        qint64 mtime;
+        qint64 size;
+        StringRef name;
+        quint32 flags;
+        quint32 actionCount;
+        StringRef title; // Name=
+        StringRef genericName;
+        StringRef comment;
+        StringRef icon;
+        StringRef exec;
+        StringRef keywords; // joined with LIST_SEPARATOR
+        StringRef categories;
+        quint32 firstAction; // actions of a file are stored next to each other like the files of a dir
+        quint32 reserved;
+    };
+
+    struct ActionRecord {
+        StringRef id;
+        StringRef name;
+        StringRef icon;
+        StringRef exec;
+    };
+
+    static constexpr quint32 IS_APP = 1;
+    // a control char no real Keywords= or Categories= value contains
+    static constexpr QChar LIST_SEPARATOR { 0x1f };
+
+    [[nodiscard]] bool validate() const;
+    [[nodiscard]] const Header* header() const { return reinterpret_cast<const Header*>(m_data); }
+    [[nodiscard]] const DirRecord* dirs() const { return reinterpret_cast<const DirRecord*>(m_data + sizeof(Header)); }
+    [[nodiscard]] const FileRecord* files() const {
+        return reinterpret_cast<const FileRecord*>(m_data + sizeof(Header) + header()->dirCount * sizeof(DirRecord));
+    }
+    [[nodiscard]] const ActionRecord* actions() const {
+        return reinterpret_cast<const ActionRecord*>(reinterpret_cast<const uchar*>(files()) + header()->fileCount * sizeof(FileRecord));
+    }
+    [[nodiscard]] const char16_t* strings() const {
+        return reinterpret_cast<const char16_t*>(reinterpret_cast<const uchar*>(actions()) + header()->actionCount * sizeof(ActionRecord));
+    }
+    [[nodiscard]] QString string(const StringRef& ref) const;
+
+    QFile m_file;
+    const uchar* m_data { nullptr };
+    qint64 m_size { 0 };
+};
\ No newline at end of file
@@ -1,37 +1,268 @@
 #include "app_launcher.h"
-#include <QSettings>
+#include "fuzzy_scorer.h"
+#include "typo_matcher.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QHash>
+#include <QThread>
+#include <QVarLengthArray>
 #include <algorithm>
+#include <functional>
 
-AppLauncher::AppLauncher() {
-    loadApplications();
+namespace {
+
+// runs work(i) for every i in [0, count) on a pool that only lives for this call. batches under two
+// chunks stay on the calling thread, starting threads would cost more than they save
+void parallelFor(const int count, const int minChunk, const std::function<void(int)>& work) {
+    const int threads = std::max(1, QThread::idealThreadCount());
+    if (threads == 1 || count < minChunk * 2) {
+        for (int i = 0; i < count; ++i) {
+            work(i);
+        }
+        return;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    const int chunks = std::min(threads * 4, (count + minChunk - 1) / minChunk);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        const int begin = static_cast<int>(static_cast<qint64>(count) * chunk / chunks);
+        const int end = static_cast<int>(static_cast<qint64>(count) * (chunk + 1) / chunks);
+        pool.start([&work, begin, end]() {
+            for (int i = begin; i < end; ++i) {
+                work(i);
+            }
+        });
+    }
+    pool.waitForDone();
 }
 
-QList<FeatureItem> AppLauncher::search(const QString& query) {
+} // namespace
+
+AppLauncher::AppLauncher(const UsageStore* usage, QObject* parent)
+    : QObject(parent)
+    , FeatureBase()
+    , m_usage(usage)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_reindexTimer(new QTimer(this))
+{
+    m_reindexTimer->setSingleShot(true);
+    m_reindexTimer->setInterval(REINDEX_DELAY_MS);
+    m_reindexPool.setMaxThreadCount(1);
+
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &AppLauncher::onDirectoryChanged);
+    connect(m_reindexTimer, &QTimer::timeout, this, &AppLauncher::reindexPending);
+}
+
+AppLauncher::~AppLauncher() {
+    m_reindexTimer->stop();
+    m_reindexPool.waitForDone();
+}
+
+QList<FeatureItem> AppLauncher::search(const QueryContext& context) {
+    const QString& query = context.query;
+    // a reindex can publish a new list at any point, this search keeps working on the one it started with
+    const CatalogPtr snapshot = catalog();
+    const QList<FeatureItem>& applications = snapshot->apps;
+
     if (query.trimmed().isEmpty()) {
-        return m_applications.mid(0, 8); // top 8 apps
+        // most used apps first, the rest stay alphabetical
+        QList<QPair<double, int>> ranked;
+        ranked.reserve(applications.size());
+        for (int i = 0; i < applications.size(); ++i) {
+            ranked.append({ frecency(applications[i]), i });
+        }
+        const qsizetype count = std::min<qsizetype>(8, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), [](const auto& a, const auto& b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+
+        QList<FeatureItem> results;
+        for (qsizetype n = 0; n < count; ++n) {
+            results.append(applications[ranked[n].second]);
+            results.last().score = 0.3;
+        }
+        return results;
+    }
+
+    if (m_candidatesFor != snapshot) {
+        m_candidates.invalidate();
+        m_candidatesFor = snapshot;
     }
 
-    QList<QPair<FeatureItem, int>> scored;
-    const QString lowerQuery = query.toLower();
+    struct Ranked {
+        int index;
+        double score;
+        double frecency;
+        bool title; // matched through the title, so it gets highlights
+    };
+    QList<Ranked> ranked;
+    QList<int> matched;
+    const FuzzyIndex::Query prepared = FuzzyIndex::prepare(query);
+    const QString& lowerQuery = prepared.folded;
+    const FuzzyIndex& titles = snapshot->titles;
+    QVarLengthArray<int, 32> positions(lowerQuery.size());
+    const auto consider = [&](const int i) {
+        // the mask throws out most titles before anything is scanned
+        if (!titles.mayMatch(i, prepared)) {
+            return;
+        }
+        if (const auto score = FuzzyScorer::score(applications[i].title, titles.text(i), lowerQuery, positions.data())) {
+            ranked.append({ i, weighed(*snapshot, i, normalizedScore(*score, lowerQuery.length())), frecency(applications[i]), true });
+            matched.append(i);
+        }
+    };
 
-    for (const auto& app : m_applications) {
-        if (int score = fuzzyMatch(lowerQuery, app.title.toLower()); score > 0) {
-            scored.append({app, score});
+    // when the query only grew, just the apps that matched last time can still match
+    const bool narrowing = m_candidates.narrows(lowerQuery);
+    const qsizetype count = narrowing ? m_candidates.matches().size() : applications.size();
+    for (qsizetype n = 0; n < count; ++n) {
+        if ((n & 63) == 0 && context.isCancelled()) {
+            return {};
         }
+        consider(narrowing ? m_candidates.matches()[n] : static_cast<int>(n));
     }
+    m_candidates.store(lowerQuery, matched);
 
-    std::sort(scored.begin(), scored.end(),
-              [](const auto& a, const auto& b) { return a.second > b.second; });
+    // "web browser" or "fire priv" dont have to be in the title, every word just has to be somewhere.
+    // an app found both ways keeps the better score
+    if (context.isCancelled()) {
+        return {};
+    }
+    const QList<QPair<int, double>> fieldHits = matchFields(*snapshot, lowerQuery);
+    if (!fieldHits.isEmpty()) {
+        QHash<int, qsizetype> rankedAt;
+        for (qsizetype n = 0; n < ranked.size(); ++n) {
+            rankedAt.insert(ranked[n].index, n);
+        }
+        for (const auto& [index, score] : fieldHits) {
+            if (const auto it = rankedAt.constFind(index); it != rankedAt.cend()) {
+                ranked[*it].score = std::max(ranked[*it].score, score);
+            } else {
+                ranked.append({ index, score, frecency(applications[index]), false });
+            }
+        }
+    }
+
+    // equal matches go to whichever app gets used more
+    std::stable_sort(ranked.begin(), ranked.end(), [](const Ranked& a, const Ranked& b) {
+        return a.score > b.score || (a.score == b.score && a.frecency > b.frecency);
+    });
 
     QList<FeatureItem> results;
-    for (const auto&[item, score] : scored) {
+    for (const Ranked& entry : ranked) {
+        FeatureItem item = applications[entry.index];
+        item.score = entry.score;
+        // only the shown few get their positions worked out again. folded indices are only title
+        // indices if lowercasing kept the length
+        if (entry.title && titles.text(entry.index).size() == item.title.size()) {
+            FuzzyScorer::score(item.title, titles.text(entry.index), lowerQuery, positions.data());
+            item.highlights = QList<int>(positions.begin(), positions.end());
+        }
         results.append(item);
         if (results.size() >= 8) break;
     }
 
+    // a typo ("firfox") usually leaves the subsequence pass with nothing, top up with titles a typo or two away
+    if (results.size() < MIN_EXACT_HITS) {
+        QList<int> found;
+        for (const Ranked& entry : std::as_const(ranked)) {
+            found.append(entry.index);
+        }
+        if (!appendTypoMatches(context, *snapshot, prepared, found, results)) {
+            return {};
+        }
+    }
+
     return results;
 }
 
+bool AppLauncher::appendTypoMatches(const QueryContext& context, const Catalog& catalog, const FuzzyIndex::Query& query,
+                                    const QList<int>& found, QList<FeatureItem>& results) const {
+    const int allowed = TypoMatcher::allowedTypos(query.folded.size());
+    if (allowed == 0) {
+        return true;
+    }
+
+    struct Near {
+        int index;
+        int distance;
+        double frecency;
+    };
+    QList<Near> near;
+    const TypoMatcher matcher(query.folded);
+    for (qsizetype i = 0; i < catalog.apps.size(); ++i) {
+        if ((i & 63) == 0 && context.isCancelled()) {
+            return false;
+        }
+        // every query char the title lacks entirely is a typo already, most titles stop here
+        if (catalog.titles.missing(i, query) > allowed || found.contains(static_cast<int>(i))) {
+            continue;
+        }
+        if (const int distance = matcher.distance(catalog.titles.text(i), allowed); distance <= allowed) {
+            near.append({ static_cast<int>(i), distance, frecency(catalog.apps[i]) });
+        }
+    }
+
+    std::stable_sort(near.begin(), near.end(), [](const Near& a, const Near& b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.frecency > b.frecency);
+    });
+    for (const Near& entry : near) {
+        if (results.size() >= 8) break;
+        results.append(catalog.apps[entry.index]);
+        // below any real match of a query this long
+        results.last().score = weighed(catalog, entry.index, TYPO_SCORE / (1 + entry.distance));
+    }
+    return true;
+}
+
+double AppLauncher::weighed(const Catalog& catalog, const qsizetype index, const double score) {
+    return index < catalog.appCount ? score : score * ACTION_WEIGHT;
+}
+
+QList<QPair<int, double>> AppLauncher::matchFields(const Catalog& catalog, const QString& foldedQuery) {
+    QStringList tokens = foldedQuery.split(' ', Qt::SkipEmptyParts);
+    tokens.removeDuplicates();
+
+    // the posting lists of every token of 3+ chars are intersected, the shorter tokens can only be
+    // checked on what's left. a query with nothing to look up stays a title only search, one or two
+    // chars would be somewhere in nearly every comment anyway
+    QList<int> candidates;
+    bool looked = false;
+    for (const QString& token : std::as_const(tokens)) {
+        if (token.size() < 3) {
+            continue;
+        }
+        const QList<int> found = catalog.fields.candidates(token);
+        candidates = looked ? TrigramIndex::intersect(candidates, found) : found;
+        looked = true;
+        if (candidates.isEmpty()) {
+            return {};
+        }
+    }
+    if (!looked) {
+        return {};
+    }
+
+    QList<QPair<int, double>> hits;
+    for (const int document : std::as_const(candidates)) {
+        double total = 0.0;
+        for (const QString& token : std::as_const(tokens)) {
+            const double score = catalog.fields.fieldScore(document, token);
+            if (score == 0.0) {
+                // trigrams can all be there without the token being there in one piece
+                total = 0.0;
+                break;
+            }
+            total += score;
+        }
+        if (total > 0.0) {
+            hits.append({ document, weighed(catalog, document, FIELD_SCORE * total / static_cast<double>(tokens.size())) });
+        }
+    }
+    return hits;
+}
+
 void AppLauncher::execute(const FeatureItem& item) {
     QStringList args = QProcess::splitCommand(item.data);
     if (args.isEmpty()) {
@@ -42,109 +273,326 @@ void AppLauncher::execute(const FeatureItem& item) {
     QProcess::startDetached(program, args);
 }
 
+void AppLauncher::buildIndex() {
+    loadApplications();
+
+    // the watcher lives on the gui thread, and only gets its paths once there's an index to update
+    QMetaObject::invokeMethod(this, &AppLauncher::watchDirs, Qt::QueuedConnection);
+}
+
 void AppLauncher::loadApplications() {
-    m_applications.clear();
-    m_seenApps.clear();
+    const QString indexPath = AppIndexCache::defaultPath();
+    const AppIndexCache cache(indexPath);
+    QList<AppIndexCache::Dir> dirs;
+    QList<int> all;
+    for (const QString& dirPath : applicationDirs()) {
+        const int cachedDir = cache.findDir(dirPath);
+        all.append(static_cast<int>(dirs.size()));
+        dirs.append(cachedDir >= 0 ? cache.dir(cachedDir) : AppIndexCache::Dir { dirPath, {}, {} });
+    }
 
-    QSet<QString> appDirPaths;
+    int parsed = 0;
+    bool changed = rescanDirs(dirs, all, parsed);
+    changed |= cache.dirCount() != dirs.size();
 
-    for (const QString& path : QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation)) {
-        appDirPaths.insert(path);
+    m_dirs = std::move(dirs);
+    publish();
+    if (changed) {
+        qDebug() << "apps ~ re-read" << parsed << "desktop files";
+        saveIndex();
     }
-    appDirPaths.insert("/var/lib/flatpak/exports/share/applications");
-    appDirPaths.insert(QDir::homePath() + "/.local/share/flatpak/exports/share/applications");
-    appDirPaths.insert("/var/lib/snapd/desktop/applications");
+}
 
-    for (const QString& dirPath : appDirPaths) {
-        QDir dir(dirPath);
-        if (!dir.exists()) {
-            continue;
+void AppLauncher::reindex(const QStringList& dirPaths) {
+    QList<int> affected;
+    for (int i = 0; i < m_dirs.size(); ++i) {
+        if (dirPaths.contains(m_dirs[i].path)) {
+            affected.append(i);
         }
+    }
 
-        const QFileInfoList files = dir.entryInfoList({"*.desktop"}, QDir::Files);
-        for (const QFileInfo& fileInfo : files) {
-            parseDesktopFile(fileInfo.absoluteFilePath());
-        }
+    int parsed = 0;
+    if (!rescanDirs(m_dirs, affected, parsed)) {
+        return;
     }
 
-    std::sort(m_applications.begin(), m_applications.end(),
-              [](const FeatureItem& a, const FeatureItem& b) {
-                  return a.title.toLower() < b.title.toLower();
-              });
+    qDebug() << "apps ~ reindexed" << dirPaths << "re-read" << parsed << "desktop files";
+    publish();
+    saveIndex();
 }
 
-void AppLauncher::parseDesktopFile(const QString& filePath) {
-    QSettings desktopFile(filePath, QSettings::IniFormat);
-    desktopFile.beginGroup("Desktop Entry");
+bool AppLauncher::rescanDirs(QList<AppIndexCache::Dir>& dirs, const QList<int>& which, int& parsed) {
+    // every task only writes to its own dir/file, so what comes out doesnt depend on scheduling
+    AppIndexCache::Dir* dirData = dirs.data();
+    QList<QList<int>> stale(which.size());
+    QList<char> changed(which.size(), 0);
+    QList<int>* staleData = stale.data();
+    char* changedData = changed.data();
 
-    if (desktopFile.value("Type", "Application").toString() != "Application") {
-        desktopFile.endGroup();
-        return;
+    // listing and stat'ing is mostly waiting on the filesystem, each dir gets its own task
+    parallelFor(static_cast<int>(which.size()), 1, [&](const int n) {
+        changedData[n] = rescanDir(dirData[which[n]], staleData[n]);
+    });
+
+    QList<AppIndexCache::File*> files;
+    QStringList paths;
+    for (int n = 0; n < which.size(); ++n) {
+        AppIndexCache::Dir& dir = dirData[which[n]];
+        AppIndexCache::File* fileData = dir.files.data();
+        for (const int i : std::as_const(stale[n])) {
+            files.append(fileData + i);
+            paths.append(dir.path + '/' + fileData[i].name);
+        }
     }
 
-    if (desktopFile.value("NoDisplay", false).toBool() || desktopFile.value("Hidden", false).toBool()) {
-        desktopFile.endGroup();
-        return;
+    const QList<AppIndexCache::File*>& toParse = files;
+    parallelFor(static_cast<int>(toParse.size()), PARSE_CHUNK, [&](const int n) {
+        toParse[n]->entry = parseDesktopFile(paths[n]);
+    });
+    parsed += static_cast<int>(toParse.size());
+
+    return !toParse.isEmpty() || std::any_of(changed.cbegin(), changed.cend(), [](const char c) { return c != 0; });
+}
+
+bool AppLauncher::rescanDir(AppIndexCache::Dir& dir, QList<int>& stale) {
+    const AppIndexCache::Stamp dirStamp = AppIndexCache::stampOf(dir.path);
+    if (!dirStamp.exists()) {
+        const bool changed = dir.stamp.exists() || !dir.files.isEmpty();
+        dir.stamp = dirStamp;
+        dir.files.clear();
+        return changed;
     }
 
-    const QString name = desktopFile.value("Name").toString();
-    QString exec = desktopFile.value("Exec").toString();
+    // file name -> index in the last scan, -1 for new files
+    QList<QPair<QString, int>> entries;
+    bool changed = dirStamp != dir.stamp;
+    if (!changed) {
+        // nothing was added or removed, so the last listing is still the listing
+        entries.reserve(dir.files.size());
+        for (int i = 0; i < dir.files.size(); ++i) {
+            entries.append({ dir.files[i].name, i });
+        }
+    } else {
+        QHash<QString, int> known;
+        for (int i = 0; i < dir.files.size(); ++i) {
+            known.insert(dir.files[i].name, i);
+        }
+        const QStringList names = QDir(dir.path).entryList({"*.desktop"}, QDir::Files, QDir::Name);
+        entries.reserve(names.size());
+        for (const QString& name : names) {
+            entries.append({ name, known.value(name, -1) });
+        }
+    }
 
-    if (name.isEmpty() || exec.isEmpty() || m_seenApps.contains(name)) {
-        desktopFile.endGroup();
-        return;
+    QList<AppIndexCache::File> previous = std::move(dir.files);
+    dir.stamp = dirStamp;
+    dir.files.clear();
+    dir.files.reserve(entries.size());
+    for (const auto& [name, index] : entries) {
+        const QString filePath = dir.path + '/' + name;
+        const AppIndexCache::Stamp stamp = AppIndexCache::stampOf(filePath);
+        if (index >= 0 && previous[index].stamp == stamp) {
+            dir.files.append(std::move(previous[index]));
+            continue;
+        }
+
+        // unreadable files are kept too, so they get another look once they change
+        changed = true;
+        if (stamp.exists()) {
+            stale.append(static_cast<int>(dir.files.size()));
+        }
+        dir.files.append({ name, stamp, std::nullopt });
     }
+    return changed;
+}
 
-    m_seenApps.insert(name);
-
-    // fuckass regexp
-    // f - the file name
-    // F - multiple file names
-    // u - a single URL
-    // U - multiple URLs
-    // d - directory
-    // D - directory of first file
-    // n - file name without path
-    // N - multiple file names without paths
-    // i - icon
-    // c - translated comment
-    // k - desktop file name
-    // v - device (eg. for mounting)
-    // m - mimetypes
-    exec = exec.replace(QRegularExpression("%[fFuUdDnNickvm]"), "").trimmed();
-
-    const QString icon = desktopFile.value("Icon").toString();
-    const QString comment = desktopFile.value("Comment").toString();
-
-    m_applications.append(FeatureItem(name, comment, icon, exec, "app"));
-    desktopFile.endGroup();
-}
-
-int AppLauncher::fuzzyMatch(const QString& query, const QString& text) {
-    if (query.isEmpty()) return 1;
-    if (text.isEmpty()) return 0;
-
-    int score = 0;
-    int queryPos = 0;
-    int lastMatchIndex = -1;
-
-    for (int i = 0; i < text.length() && queryPos < query.length(); ++i) {
-        if (text[i] == query[queryPos]) {
-            int currentScore = 1;
-            if (lastMatchIndex == -1) {
-                currentScore += 10;
+void AppLauncher::publish() {
+    // xdg precedence: a desktop file id (its name, the dirs arent scanned recursively) belongs to the
+    // first dir that has it. that includes ids that dont list anything, a Hidden=true copy in
+    // ~/.local/share/applications is how a user hides a system app
+    QList<const DesktopEntry*> entries;
+    QSet<QString> claimed;
+    for (const AppIndexCache::Dir& dir : std::as_const(m_dirs)) {
+        for (const AppIndexCache::File& file : dir.files) {
+            if (claimed.contains(file.name)) {
+                continue;
             }
-            if (lastMatchIndex == i - 1) {
-                currentScore += 5;
+            claimed.insert(file.name);
+            if (file.entry) {
+                entries.append(&*file.entry);
             }
-            if (i == 0 || text[i-1].isSpace()) {
-                currentScore += 8;
+        }
+    }
+
+    // stable, so two apps with the same name stay in precedence order
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const DesktopEntry* a, const DesktopEntry* b) {
+                         return a->name.compare(b->name, Qt::CaseInsensitive) < 0;
+                     });
+
+    QList<FeatureItem> applications;
+    QStringList titles;
+    QList<TrigramIndex::Fields> fields;
+    applications.reserve(entries.size());
+    titles.reserve(entries.size());
+    fields.reserve(entries.size());
+    for (const DesktopEntry* entry : std::as_const(entries)) {
+        applications.append(FeatureItem(entry->name, entry->comment, entry->icon, entry->exec, "app"));
+        titles.append(entry->name);
+        fields.append(searchFieldsOf(*entry));
+    }
+
+    // desktop actions come after every app, so an empty query and equal scores still list the apps first.
+    // "Firefox: New Private Window" goes through the same title matching as the apps, and the index
+    // finds "fire priv" through the action's name and the app's
+    const qsizetype appCount = applications.size();
+    for (qsizetype n = 0; n < appCount; ++n) {
+        const DesktopEntry* entry = entries[n];
+        for (const DesktopAction& action : entry->actions) {
+            const QString title = entry->name + ": " + action.name;
+            applications.append(FeatureItem(title, entry->name, action.icon, action.exec, "action"));
+            titles.append(title);
+            TrigramIndex::Fields actionFields;
+            actionFields[TrigramIndex::Name] = action.name;
+            actionFields[TrigramIndex::Binary] = fields[n][TrigramIndex::Binary];
+            actionFields[TrigramIndex::App] = entry->name;
+            fields.append(actionFields);
+        }
+    }
+
+    m_catalog.store(std::make_shared<const Catalog>(
+        Catalog { std::move(applications), appCount, FuzzyIndex(titles), TrigramIndex(fields) }));
+    invalidateResults();
+}
+
+void AppLauncher::saveIndex() const {
+    AppIndexCache::Writer writer;
+    for (const AppIndexCache::Dir& dir : m_dirs) {
+        writer.beginDir(dir.path, dir.stamp);
+        for (const AppIndexCache::File& file : dir.files) {
+            writer.addFile(file.name, file.stamp, file.entry);
+        }
+    }
+    writer.save(AppIndexCache::defaultPath());
+}
+
+void AppLauncher::watchDirs() {
+    // a dir that doesnt exist yet (no flatpak installed so far) is watched through its closest existing
+    // parent, so it gets noticed once it's created and then watched itself
+    QStringList paths;
+    for (QString path : applicationDirs()) {
+        while (!QFileInfo::exists(path) && path != "/") {
+            path = QFileInfo(path).path();
+        }
+        paths.append(path);
+    }
+    paths.removeDuplicates();
+
+    const QStringList watched = m_watcher->directories();
+    for (const QString& path : watched) {
+        if (!paths.contains(path)) {
+            m_watcher->removePath(path);
+        }
+    }
+    for (const QString& path : std::as_const(paths)) {
+        if (!watched.contains(path)) {
+            m_watcher->addPath(path);
+        }
+    }
+}
+
+void AppLauncher::onDirectoryChanged(const QString& path) {
+    m_pendingDirs.insert(path);
+    m_reindexTimer->start();
+}
+
+void AppLauncher::reindexPending() {
+    // a change to a watched parent only matters for the app dirs under it
+    QStringList dirPaths;
+    for (const QString& dirPath : applicationDirs()) {
+        for (const QString& changed : std::as_const(m_pendingDirs)) {
+            if (dirPath == changed || dirPath.startsWith(changed.endsWith('/') ? changed : changed + '/')) {
+                dirPaths.append(dirPath);
+                break;
             }
-            score += currentScore;
-            lastMatchIndex = i;
-            queryPos++;
         }
     }
+    m_pendingDirs.clear();
+    if (dirPaths.isEmpty()) {
+        return;
+    }
+
+    m_reindexPool.start([this, dirPaths]() {
+        reindex(dirPaths);
+        // dirs can have appeared or disappeared, the watches follow them
+        QMetaObject::invokeMethod(this, &AppLauncher::watchDirs, Qt::QueuedConnection);
+    });
+}
+
+QStringList AppLauncher::applicationDirs() {
+    // highest precedence first: XDG_DATA_HOME, then XDG_DATA_DIRS in order. the flatpak/snap exports are
+    // usually in XDG_DATA_DIRS already, if not they go last with the user installation first
+    QStringList dirs = QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation);
+    dirs.append(QDir::homePath() + "/.local/share/flatpak/exports/share/applications");
+    dirs.append("/var/lib/flatpak/exports/share/applications");
+    dirs.append("/var/lib/snapd/desktop/applications");
+    dirs.removeDuplicates();
+    return dirs;
+}
+
+std::optional<DesktopEntry> AppLauncher::parseDesktopFile(const QString& filePath) {
+    // the locale is read once, the parser itself is fine to share
+    static const DesktopEntryParser parser;
+    return parser.parseFile(filePath);
+}
+
+TrigramIndex::Fields AppLauncher::searchFieldsOf(const DesktopEntry& entry) {
+    TrigramIndex::Fields fields;
+    fields[TrigramIndex::Name] = entry.name;
+    fields[TrigramIndex::GenericName] = entry.genericName;
+    fields[TrigramIndex::Keywords] = entry.keywords.join(' ');
+    fields[TrigramIndex::Categories] = entry.categories.join(' ');
+    fields[TrigramIndex::Comment] = entry.comment;
+    fields[TrigramIndex::Binary] = binaryOf(entry.exec);
+    return fields;
+}
+
+QString AppLauncher::binaryOf(const QString& exec) {
+    const QStringList args = QProcess::splitCommand(exec);
+    qsizetype at = 0;
+    // env FOO=bar app ...
+    if (at < args.size() && QFileInfo(args[at]).fileName() == "env") {
+        ++at;
+    }
+    while (at < args.size() && args[at].contains('=') && !args[at].startsWith('-')) {
+        ++at;
+    }
+    if (at >= args.size()) {
+        return {};
+    }
+
+    const QString binary = QFileInfo(args[at]).fileName();
+    if (binary != "flatpak") {
+        return binary;
+    }
+    // flatpak run [--options] org.mozilla.firefox, the last part of the app id is the useful bit
+    for (qsizetype n = at + 1; n < args.size(); ++n) {
+        if (args[n] != "run" && !args[n].startsWith('-')) {
+            return args[n].section('.', -1);
+        }
+    }
+    return binary;
+}
+
+double AppLauncher::frecency(const FeatureItem& app) const {
+    return m_usage ? m_usage->frecency(getName(), app) : 0.0;
+}
+
+AppLauncher::CatalogPtr AppLauncher::catalog() const {
+    return m_catalog.load();
+}
 
-    return (queryPos == query.length()) ? score : 0;
+double AppLauncher::normalizedScore(const int score, const qsizetype queryLength) {
+    // a straight prefix of the title scores about 1, the odd boundary heavy match can go over that
+    return std::clamp(static_cast<double>(score) / FuzzyScorer::prefixScore(queryLength), 0.0, 1.0);
 }
\ No newline at end of file
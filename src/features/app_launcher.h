@@ -1,26 +1,111 @@
 #pragma once
 
 #include "feature_base.h"
+#include "candidate_cache.h"
+#include "app_index_cache.h"
+#include "desktop_entry.h"
+#include "fuzzy_index.h"
+#include "snapshot_cell.h"
+#include "trigram_index.h"
+#include "../usage_store.h"
+#include <QObject>
 #include <QDir>
+#include <QFileSystemWatcher>
 #include <QProcess>
 #include <QStandardPaths>
 #include <QSet>
-#include <QRegularExpression>
+#include <QThreadPool>
+#include <QTimer>
+#include <memory>
+#include <optional>
+
+class AppLauncher final : public QObject, public FeatureBase {
+    Q_OBJECT
 
-class AppLauncher final : public FeatureBase {
 public:
-    AppLauncher();
+    explicit AppLauncher(const UsageStore* usage = nullptr, QObject* parent = nullptr);
+    ~AppLauncher() override;
+
     [[nodiscard]] QString getName() const override { return "Applications"; }
     [[nodiscard]] QString getIcon() const override { return "applications-system"; }
-    QList<FeatureItem> search(const QString& query) override;
+    [[nodiscard]] bool isThreadSafe() const override { return true; }
+    QList<FeatureItem> search(const QueryContext& context) override;
     void execute(const FeatureItem& item) override;
 
+    // package managers drop several files in a row, they get picked up together
+    static constexpr int REINDEX_DELAY_MS = 250;
+    // files per parse task, fewer than two of these just get parsed on the calling thread
+    static constexpr int PARSE_CHUNK = 32;
+    // fewer subsequence matches than this and search() also looks for titles the query has a typo against
+    static constexpr qsizetype MIN_EXACT_HITS = 3;
+    // what a match at distance d scores is TYPO_SCORE / (1 + d), well under any real match
+    static constexpr double TYPO_SCORE = 0.7;
+    // what an app whose name starts with every query word scores through TrigramIndex, a bit under a
+    // title prefix match
+    static constexpr double FIELD_SCORE = 0.9;
+    // desktop actions score this much of what their match is worth, an app and its own actions matching
+    // equally well list the app first
+    static constexpr double ACTION_WEIGHT = 0.95;
+
+protected:
+    void buildIndex() override;
+
+private slots:
+    void onDirectoryChanged(const QString& path);
+    void reindexPending();
+
 private:
+    friend struct BenchAccess; // src/bench
+
+    // what search() works on, a reindex replaces it as a whole
+    struct Catalog {
+        QList<FeatureItem> apps; // the apps, then every app's desktop actions
+        qsizetype appCount { 0 }; // apps[appCount...] are actions
+        FuzzyIndex titles; // same order as apps
+        TrigramIndex fields; // name, generic name, keywords, categories, comment and binary, same order
+    };
+    using CatalogPtr = SnapshotCell<Catalog>::Ptr;
+
     void loadApplications();
-    void parseDesktopFile(const QString& filePath);
+    void reindex(const QStringList& dirPaths);
+    // rescans dirs[which...] and then parses every new or changed file in them, both spread over a
+    // temporary pool. false if nothing changed
+    static bool rescanDirs(QList<AppIndexCache::Dir>& dirs, const QList<int>& which, int& parsed);
+    // updates dir's listing and stamps, files that need parsing are left empty and their indices put in stale
+    static bool rescanDir(AppIndexCache::Dir& dir, QList<int>& stale);
+    // merges m_dirs into a new list for search() to pick up
+    void publish();
+    void saveIndex() const;
+    void watchDirs();
+
+    // nullopt for anything that shouldnt be listed (hidden, not an application, no name/exec)
+    static std::optional<DesktopEntry> parseDesktopFile(const QString& filePath);
+    static TrigramIndex::Fields searchFieldsOf(const DesktopEntry& entry);
+    // "firefox" out of "env MOZ_X=1 /usr/bin/firefox %u", the app id's last part for flatpak run
+    static QString binaryOf(const QString& exec);
+    static QStringList applicationDirs();
+
+    static double normalizedScore(int score, qsizetype queryLength);
+    // score scaled down if index is a desktop action
+    static double weighed(const Catalog& catalog, qsizetype index, double score);
+    // apps with every word of query (folded) in one of their fields, with their weighted scores
+    static QList<QPair<int, double>> matchFields(const Catalog& catalog, const QString& foldedQuery);
+    // appends (up to 8 results) the titles within TypoMatcher::allowedTypos of query, skipping the ones
+    // already found. false if the search got cancelled on the way
+    bool appendTypoMatches(const QueryContext& context, const Catalog& catalog, const FuzzyIndex::Query& query,
+                           const QList<int>& found, QList<FeatureItem>& results) const;
+
+    [[nodiscard]] double frecency(const FeatureItem& app) const;
+    [[nodiscard]] CatalogPtr catalog() const;
 
-    static int fuzzyMatch(const QString& query, const QString& text);
+    const UsageStore* m_usage;
+    QList<AppIndexCache::Dir> m_dirs; // buildIndex() fills it, after that only the reindex pool touches it
+    SnapshotCell<Catalog> m_catalog; // a reindex publishes a whole new one, search() never locks
+    CandidateCache m_candidates; // only touched from search(), which never runs twice at once
+    CatalogPtr m_candidatesFor; // the catalog m_candidates indexes into
 
-    QList<FeatureItem> m_applications;
-    QSet<QString> m_seenApps; // prevent duplicates
+    QFileSystemWatcher* m_watcher;
+    QTimer* m_reindexTimer;
+    QSet<QString> m_pendingDirs; // watched paths that changed since the last reindex
+    QThreadPool m_reindexPool; // one thread so reindexes never overlap, last so it's waited for first
 };
\ No newline at end of file
@@ -4,11 +4,22 @@
 #include <QApplication>
 #include "../third_party/exprtk.hpp"
 
-QList<FeatureItem> Calculator::search(const QString& query) {
+namespace {
+
+// digits, operators, parens and spaces only. the dispatcher skips anything else before search() runs
+const QRegularExpression& expressionShape() {
+    static const QRegularExpression shape("^[0-9+\\-*/().\\s]+$");
+    return shape;
+}
+
+} // namespace
+
+QList<FeatureItem> Calculator::search(const QueryContext& context) {
     QList<FeatureItem> results;
+    const QString& query = context.query;
     if (query.isEmpty() || !isValidExpression(query)) return results;
 
-    if (const double result = evaluateExpression(query); !std::isnan(result) && !std::isinf(result)) {
+    if (const double result = evaluateExpression(query, context); !std::isnan(result) && !std::isinf(result)) {
         const QString resultStr = QString::number(result, 'g', 10);
         results.append(FeatureItem(
             resultStr,
@@ -17,10 +28,18 @@ QList<FeatureItem> Calculator::search(const QString& query) {
             resultStr,
             "calculator"
         ));
+        results.last().score = 1.0;
     }
     return results;
 }
 
+FeatureTriggers Calculator::triggers() const {
+    FeatureTriggers triggers;
+    triggers.minLength = 1;
+    triggers.shape = expressionShape();
+    return triggers;
+}
+
 void Calculator::execute(const FeatureItem& item) {
     if (QClipboard* clipboard = QApplication::clipboard()) {
         clipboard->setText(item.data);
@@ -30,12 +49,11 @@ void Calculator::execute(const FeatureItem& item) {
 bool Calculator::isValidExpression(const QString& expr) {
     if (expr.trimmed().isEmpty()) return false;
 
-    const QRegularExpression regex("^[0-9+\\-*/().\\s]+$");
-    return regex.match(expr).hasMatch() &&
-           expr.contains(QRegularExpression("[0-9+\\-*/]"));
+    static const QRegularExpression operand("[0-9+\\-*/]");
+    return expressionShape().match(expr).hasMatch() && expr.contains(operand);
 }
 
-double Calculator::evaluateExpression(const QString& expr) {
+double Calculator::evaluateExpression(const QString& expr, const QueryContext& context) {
     typedef double T;
     exprtk::symbol_table<T> symbol_table;
     exprtk::expression<T> expression;
@@ -44,10 +62,19 @@ double Calculator::evaluateExpression(const QString& expr) {
     symbol_table.add_constants();
     expression.register_symbol_table(symbol_table);
 
+    // compiling is the expensive part, skip it (and the evaluation) for stale keystrokes
+    if (context.isCancelled()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
     if (const std::string e = expr.toStdString(); !parser.compile(e, expression)) {
         return std::numeric_limits<double>::quiet_NaN();
     }
 
+    if (context.isCancelled()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
     try {
         return expression.value();
     } catch (...) {
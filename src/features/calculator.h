@@ -7,10 +7,14 @@ class Calculator final : public FeatureBase {
 public:
     [[nodiscard]] QString getName() const override { return "Calculator"; }
     [[nodiscard]] QString getIcon() const override { return "accessories-calculator"; }
-    QList<FeatureItem> search(const QString& query) override;
+    [[nodiscard]] bool isThreadSafe() const override { return true; }
+    [[nodiscard]] FeatureTriggers triggers() const override;
+    QList<FeatureItem> search(const QueryContext& context) override;
     void execute(const FeatureItem& item) override;
 
 private:
-    static double evaluateExpression(const QString& expr);
+    friend struct BenchAccess; // src/bench
+
+    static double evaluateExpression(const QString& expr, const QueryContext& context = QueryContext());
     static bool isValidExpression(const QString& expr);
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <utility>
+
+// remembers which corpus entries matched the last query. when the next query only appends to it
+// (fi -> fir -> fire) nothing outside that set can match anymore, so only those get rescanned.
+// anything else (backspace, edits in the middle) falls back to a full scan.
+// only valid for matchers where a match for "abc" implies a match for "ab" (subsequence, substring)
+class CandidateCache {
+public:
+    [[nodiscard]] bool narrows(const QString& query) const {
+        return m_valid && !m_query.isEmpty() && query.startsWith(m_query);
+    }
+
+    [[nodiscard]] const QList<int>& matches() const { return m_matches; }
+
+    void store(const QString& query, QList<int> matches) {
+        m_query = query;
+        m_matches = std::move(matches);
+        m_valid = true;
+    }
+
+    // has to be called whenever the corpus changes, the stored indices point into it
+    void invalidate() {
+        m_valid = false;
+        m_query.clear();
+        m_matches.clear();
+    }
+
+private:
+    QString m_query;
+    QList<int> m_matches;
+    bool m_valid { false };
+};
\ No newline at end of file
@@ -18,19 +18,30 @@ Clipboard::Clipboard(QObject* parent)
       m_storageDir(QStandardPaths::writableLocation(QStandardPaths::HomeLocation) + "/.rnux/clipboard"),
       m_encryptionEnabled(true) {
     setup();
-    initializeEncryption();
-    loadHistory();
 }
 
 Clipboard::~Clipboard() {
-    saveHistory();
+    // an unloaded history would overwrite the one on disk with nothing
+    if (isReady()) {
+        saveHistory();
+    }
 }
 
 void Clipboard::setup() {
     if (!m_storageDir.exists()) {
         m_storageDir.mkpath(".");
     }
-    connect(m_clipboard, &QClipboard::dataChanged, this, &Clipboard::onClipboardChanged);
+}
+
+void Clipboard::buildIndex() {
+    // the key derivation and decrypting the history are what make this slow
+    initializeEncryption();
+    loadHistory();
+
+    // only start recording once the history is loaded, QClipboard has to be touched from the gui thread
+    QMetaObject::invokeMethod(this, [this]() {
+        connect(m_clipboard, &QClipboard::dataChanged, this, &Clipboard::onClipboardChanged);
+    }, Qt::QueuedConnection);
 }
 
 void Clipboard::initializeEncryption() {
@@ -162,7 +173,8 @@ void Clipboard::addTextItem(const QString& text) {
         return;
     }
 
-    for(const auto& item : m_history) {
+    const History current = m_history.load();
+    for(const auto& item : *current) {
         if(item.type == "text" && item.data == text) {
             return;
         }
@@ -174,25 +186,28 @@ void Clipboard::addTextItem(const QString& text) {
     newItem.preview = createPreview(text);
     newItem.timestamp = QDateTime::currentDateTime();
 
-    m_history.prepend(newItem);
+    QList<ClipboardItem> history = *current;
+    history.prepend(newItem);
 
     int textCount = 0;
-    for (qsizetype i = m_history.size() - 1; i >= 0; --i) {
-        if (m_history[static_cast<int>(i)].type == "text") {
+    for (qsizetype i = history.size() - 1; i >= 0; --i) {
+        if (history[static_cast<int>(i)].type == "text") {
             textCount++;
             if (textCount > 500) {
-                m_history.removeAt(static_cast<int>(i));
+                history.removeAt(static_cast<int>(i));
             }
         }
     }
 
+    publishHistory(std::move(history));
     saveHistory();
 }
 
 void Clipboard::addImageItem(const QImage& image) {
-    for(qsizetype i = 0; i < qMin(static_cast<qsizetype>(5), m_history.size()); ++i) {
-        if(m_history[static_cast<int>(i)].type == "image") {
-            if(QImage recentImage = loadImage(m_history[static_cast<int>(i)].filePath); recentImage == image) {
+    const History current = m_history.load();
+    for(qsizetype i = 0; i < qMin(static_cast<qsizetype>(5), current->size()); ++i) {
+        if((*current)[static_cast<int>(i)].type == "image") {
+            if(QImage recentImage = loadImage((*current)[static_cast<int>(i)].filePath); recentImage == image) {
                 return;
             }
         }
@@ -211,24 +226,31 @@ void Clipboard::addImageItem(const QImage& image) {
     newItem.timestamp = QDateTime::currentDateTime();
     newItem.filePath = filePath;
 
-    m_history.prepend(newItem);
+    QList<ClipboardItem> history = *current;
+    history.prepend(newItem);
 
     int imageCount = 0;
-    for (qsizetype i = m_history.size() - 1; i >= 0; --i) {
-        if (m_history[static_cast<int>(i)].type == "image") {
+    for (qsizetype i = history.size() - 1; i >= 0; --i) {
+        if (history[static_cast<int>(i)].type == "image") {
             imageCount++;
             // images have a lower history size, mainly to save disk space
             // ill probably add some kind of settings menu later so things like these can be configured
             if (imageCount > 100) {
-                QFile::remove(m_history[static_cast<int>(i)].filePath);
-                m_history.removeAt(static_cast<int>(i));
+                QFile::remove(history[static_cast<int>(i)].filePath);
+                history.removeAt(static_cast<int>(i));
             }
         }
     }
 
+    publishHistory(std::move(history));
     saveHistory();
 }
 
+void Clipboard::publishHistory(QList<ClipboardItem> history) {
+    m_history.store(std::make_shared<const QList<ClipboardItem>>(std::move(history)));
+    invalidateResults();
+}
+
 QString Clipboard::storeImage(const QImage& image) const {
     if (image.isNull()) {
         return {};
@@ -249,32 +271,37 @@ QImage Clipboard::loadImage(const QString& filePath) {
     return QImage(filePath);
 }
 
-QList<FeatureItem> Clipboard::search(const QString& query) {
+QList<FeatureItem> Clipboard::search(const QueryContext& context) {
     QList<FeatureItem> results;
-    const QString lowerQuery = query.toLower();
-    const QStringList aliases = {"clipboard ", "clip "};
-    QString searchQuery;
-    bool aliasFound = false;
-
-    for (const auto& alias : aliases) {
-        if (lowerQuery.startsWith(alias)) {
-            searchQuery = query.mid(alias.length());
-            aliasFound = true;
-            break;
-        }
-    }
-
-    if (!aliasFound && (lowerQuery == "clipboard" || lowerQuery == "clip")) {
-        aliasFound = true;
-        searchQuery = "";
-    }
 
-    if (!aliasFound) {
+    // the router only sends "clip"/"clipboard", alone or followed by what to look for
+    if (context.trigger.isEmpty()) {
         return results;
     }
+    const FuzzyIndex::Query prepared = FuzzyIndex::prepare(context.argument);
+    const QString& searchQuery = prepared.folded;
+
+    // a copy can publish a new history at any point, this search stays on the one it started with
+    const History snapshot = m_history.load();
+    const QList<ClipboardItem>& history = *snapshot;
+    if (m_candidatesFor != snapshot) {
+        m_candidates.invalidate();
+        m_candidatesFor = snapshot;
+        // folded once per history change instead of once per entry per keystroke
+        QStringList previews;
+        previews.reserve(history.size());
+        for (const auto& item : history) {
+            previews.append(item.preview);
+        }
+        m_previews = FuzzyIndex(previews);
+    }
+
+    QList<int> matched;
+    const auto consider = [&](const int i) {
+        const auto&[data, preview, type, timestamp, filePath] = history[i];
+        if (searchQuery.isEmpty() || m_previews.contains(i, prepared)) {
+            matched.append(i);
 
-    for (const auto&[data, preview, type, timestamp, filePath] : m_history) {
-        if (searchQuery.isEmpty() || preview.toLower().contains(searchQuery)) {
             FeatureItem featureItem;
             featureItem.title = preview;
             featureItem.subtitle = timestamp.toString(Qt::ISODate);
@@ -287,15 +314,38 @@ QList<FeatureItem> Clipboard::search(const QString& query) {
 
             featureItem.data = filePath.isEmpty() ? data : filePath;
             featureItem.type = "clipboard";
+            featureItem.score = 0.9; // asked for by alias, newest first through tie order
             results.append(featureItem);
         }
+    };
+
+    // typing more only ever drops entries, so rescan what matched last time instead of the whole history
+    if (m_candidates.narrows(searchQuery)) {
+        for (const int i : m_candidates.matches()) {
+            consider(i);
+        }
+    } else {
+        for (int i = 0; i < history.size(); ++i) {
+            consider(i);
+        }
     }
+    m_candidates.store(searchQuery, matched);
 
     return results;
 }
 
+FeatureTriggers Clipboard::triggers() const {
+    FeatureTriggers triggers;
+    triggers.prefixes = {"clipboard", "clip"};
+    triggers.exclusive = true;
+    triggers.prefixOnly = true;
+    triggers.matchesBarePrefix = true;
+    return triggers;
+}
+
 void Clipboard::execute(const FeatureItem& item) {
-    for (const auto& clipboardItem : m_history) {
+    const History history = m_history.load();
+    for (const auto& clipboardItem : *history) {
         if (QString data = clipboardItem.filePath.isEmpty() ? clipboardItem.data : clipboardItem.filePath; data == item.data) {
             if (clipboardItem.type == "text") {
                 m_clipboard->setText(clipboardItem.data);
@@ -311,7 +361,8 @@ void Clipboard::execute(const FeatureItem& item) {
 
 void Clipboard::saveHistory() {
     QJsonArray historyArray;
-    for (const auto&[data, preview, type, timestamp, filePath] : m_history) {
+    const History history = m_history.load();
+    for (const auto&[data, preview, type, timestamp, filePath] : *history) {
         QJsonObject itemObject;
         itemObject["t"] = type;
         itemObject["d"] = QString::fromLatin1(encrypt(data).toBase64());
@@ -337,6 +388,7 @@ void Clipboard::loadHistory() {
     }
 
     if (const QJsonDocument doc = QJsonDocument::fromJson(file.readAll()); doc.isArray()) {
+        QList<ClipboardItem> history;
         QJsonArray historyArray = doc.array();
         for (const auto& itemValue : historyArray) {
             QJsonObject itemObject = itemValue.toObject();
@@ -346,7 +398,8 @@ void Clipboard::loadHistory() {
             item.preview = decrypt(QByteArray::fromBase64(itemObject["p"].toString().toLatin1()));
             item.timestamp = QDateTime::fromString(itemObject["ts"].toString(), Qt::ISODate);
             item.filePath = itemObject["f"].toString();
-            m_history.append(item);
+            history.append(item);
         }
+        publishHistory(std::move(history));
     }
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "feature_base.h"
+#include "candidate_cache.h"
+#include "snapshot_cell.h"
+#include "fuzzy_index.h"
 #include <QObject>
 #include <QClipboard>
 #include <QList>
@@ -33,13 +36,21 @@ public:
 
     [[nodiscard]] QString getName() const override { return "Clipboard"; }
     [[nodiscard]] QString getIcon() const override { return "edit-copy"; }
-    QList<FeatureItem> search(const QString& query) override;
+    [[nodiscard]] FeatureTriggers triggers() const override;
+    // the history is only ever replaced as a whole, so a worker can search it while a copy comes in
+    [[nodiscard]] bool isThreadSafe() const override { return true; }
+    QList<FeatureItem> search(const QueryContext& context) override;
     void execute(const FeatureItem& item) override;
 
+protected:
+    void buildIndex() override;
+
 private slots:
     void onClipboardChanged();
 
 private:
+    friend struct BenchAccess; // src/bench
+
     void setup();
     void loadHistory();
     void saveHistory();
@@ -57,7 +68,14 @@ private:
     static QString createPreview(const QString& text) ;
 
     QClipboard* m_clipboard;
-    QList<ClipboardItem> m_history;
+    using History = SnapshotCell<QList<ClipboardItem>>::Ptr;
+    // history is written to from the gui thread only, every change publishes a new list
+    void publishHistory(QList<ClipboardItem> history);
+
+    SnapshotCell<QList<ClipboardItem>> m_history;
+    CandidateCache m_candidates; // only touched from search()
+    History m_candidatesFor; // the history m_candidates and m_previews index into
+    FuzzyIndex m_previews; // only touched from search()
     QDir m_storageDir;
     QByteArray m_encryptionKey;
     bool m_encryptionEnabled;
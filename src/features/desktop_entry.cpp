@@ -0,0 +1,434 @@
+#include "desktop_entry.h"
+#include <QFile>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+bool equals(const QByteArrayView view, const char* literal) {
+    const auto length = static_cast<qsizetype>(std::strlen(literal));
+    return view.size() == length && std::memcmp(view.data(), literal, length) == 0;
+}
+
+bool startsWith(const QByteArrayView view, const char* literal) {
+    const auto length = static_cast<qsizetype>(std::strlen(literal));
+    return view.size() >= length && std::memcmp(view.data(), literal, length) == 0;
+}
+
+QByteArrayView trimmed(QByteArrayView view) {
+    while (!view.isEmpty() && (view[0] == ' ' || view[0] == '\t')) {
+        view = view.sliced(1);
+    }
+    while (!view.isEmpty() && (view[view.size() - 1] == ' ' || view[view.size() - 1] == '\t')) {
+        view = view.first(view.size() - 1);
+    }
+    return view;
+}
+
+const char* find(const QByteArrayView view, const char c) {
+    return view.isEmpty() ? nullptr : static_cast<const char*>(std::memchr(view.data(), c, view.size()));
+}
+
+bool isTrue(const QByteArrayView value) {
+    return equals(value, "true");
+}
+
+// best value seen so far for a localized key
+struct Localized {
+    QByteArrayView value;
+    int rank { -1 }; // -1 until there is one
+
+    void offer(const QByteArrayView candidate, const int candidateRank) {
+        if (rank < 0 || candidateRank < rank) {
+            value = candidate;
+            rank = candidateRank;
+        }
+    }
+};
+
+// the keys rnux reads out of a group, all still pointing into the file
+struct Group {
+    Localized name;
+    Localized genericName;
+    Localized comment;
+    Localized keywords;
+    QByteArrayView type;
+    QByteArrayView icon;
+    QByteArrayView exec;
+    QByteArrayView noDisplay;
+    QByteArrayView hidden;
+    QByteArrayView actions;
+    QByteArrayView categories;
+
+    void assign(const QByteArrayView key, const QByteArrayView value, const int rank, const bool localized) {
+        if (equals(key, "Name")) {
+            name.offer(value, rank);
+        } else if (equals(key, "GenericName")) {
+            genericName.offer(value, rank);
+        } else if (equals(key, "Comment")) {
+            comment.offer(value, rank);
+        } else if (equals(key, "Keywords")) {
+            keywords.offer(value, rank);
+        } else if (!localized) {
+            // a key showing up twice is invalid, the first one counts
+            const auto plain = [&value](QByteArrayView& field) {
+                if (field.isNull()) {
+                    field = value;
+                }
+            };
+            if (equals(key, "Type")) plain(type);
+            else if (equals(key, "Icon")) plain(icon);
+            else if (equals(key, "Exec")) plain(exec);
+            else if (equals(key, "NoDisplay")) plain(noDisplay);
+            else if (equals(key, "Hidden")) plain(hidden);
+            else if (equals(key, "Actions")) plain(actions);
+            else if (equals(key, "Categories")) plain(categories);
+        }
+    }
+};
+
+QString unescaped(const QByteArrayView raw, const bool listItem) {
+    if (!find(raw, '\\')) {
+        return QString::fromUtf8(raw);
+    }
+
+    QByteArray out;
+    out.reserve(raw.size());
+    for (qsizetype i = 0; i < raw.size(); ++i) {
+        if (raw[i] != '\\' || i + 1 == raw.size()) {
+            out.append(raw[i]);
+            continue;
+        }
+        switch (const char next = raw[++i]) {
+        case 's': out.append(' '); break;
+        case 'n': out.append('\n'); break;
+        case 't': out.append('\t'); break;
+        case 'r': out.append('\r'); break;
+        case '\\': out.append('\\'); break;
+        case ';':
+            if (!listItem) {
+                out.append('\\');
+            }
+            out.append(';');
+            break;
+        default:
+            // not an escape the spec knows, keep it as written
+            out.append('\\');
+            out.append(next);
+        }
+    }
+    return QString::fromUtf8(out);
+}
+
+} // namespace
+
+DesktopEntryParser::DesktopEntryParser(const QByteArray& locale) {
+    // lang_COUNTRY.ENCODING@MODIFIER, the encoding plays no part in matching
+    QByteArray lang = locale;
+    QByteArray modifier;
+    QByteArray country;
+    if (const qsizetype at = lang.indexOf('@'); at >= 0) {
+        modifier = lang.mid(at + 1);
+        lang.truncate(at);
+    }
+    if (const qsizetype dot = lang.indexOf('.'); dot >= 0) {
+        lang.truncate(dot);
+    }
+    if (const qsizetype underscore = lang.indexOf('_'); underscore >= 0) {
+        country = lang.mid(underscore + 1);
+        lang.truncate(underscore);
+    }
+    if (lang.isEmpty() || lang == "C" || lang == "POSIX") {
+        return;
+    }
+
+    if (!country.isEmpty() && !modifier.isEmpty()) {
+        m_locales.append(lang + '_' + country + '@' + modifier);
+    }
+    if (!country.isEmpty()) {
+        m_locales.append(lang + '_' + country);
+    }
+    if (!modifier.isEmpty()) {
+        m_locales.append(lang + '@' + modifier);
+    }
+    m_locales.append(lang);
+}
+
+QByteArray DesktopEntryParser::systemLocale() {
+    for (const char* variable : { "LC_ALL", "LC_MESSAGES", "LANG" }) {
+        if (QByteArray value = qgetenv(variable); !value.isEmpty()) {
+            return value;
+        }
+    }
+    return {};
+}
+
+int DesktopEntryParser::localeRank(const QByteArrayView locale) const {
+    for (int i = 0; i < m_locales.size(); ++i) {
+        if (m_locales[i].size() == locale.size() && std::memcmp(m_locales[i].constData(), locale.data(), locale.size()) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+std::optional<DesktopEntry> DesktopEntryParser::parseFile(const QString& path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+
+    const qint64 size = file.size();
+    if (size <= 0) {
+        return std::nullopt;
+    }
+    if (uchar* mapped = file.map(0, size)) {
+        std::optional<DesktopEntry> entry = parse(QByteArrayView(reinterpret_cast<const char*>(mapped), static_cast<qsizetype>(size)), path);
+        file.unmap(mapped);
+        return entry;
+    }
+
+    // some files cant be mapped (fifos, odd filesystems), those just get read
+    const QByteArray data = file.readAll();
+    return parse(data, path);
+}
+
+std::optional<DesktopEntry> DesktopEntryParser::parse(QByteArrayView data, const QString& path) const {
+    enum class Section { Other, Entry, Action };
+
+    if (startsWith(data, "\xEF\xBB\xBF")) {
+        data = data.sliced(3);
+    }
+
+    const int unlocalized = static_cast<int>(m_locales.size());
+    Section section = Section::Other;
+    bool seenEntry = false;
+    Group entry;
+    QList<QPair<QByteArrayView, Group>> actionGroups;
+
+    const char* cursor = data.data();
+    const char* const end = cursor + data.size();
+    while (cursor < end) {
+        const auto* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+        const char* lineEnd = newline ? newline : end;
+        QByteArrayView line = trimmed(QByteArrayView(cursor, lineEnd - cursor));
+        cursor = newline ? newline + 1 : end;
+
+        if (!line.isEmpty() && line[line.size() - 1] == '\r') {
+            line = trimmed(line.first(line.size() - 1));
+        }
+        if (line.isEmpty() || line[0] == '#') {
+            continue;
+        }
+
+        if (line[0] == '[') {
+            if (line[line.size() - 1] != ']') {
+                section = Section::Other;
+                continue;
+            }
+            const QByteArrayView group = line.sliced(1, line.size() - 2);
+            if (equals(group, "Desktop Entry")) {
+                // a second [Desktop Entry] is invalid, the first one counts
+                section = seenEntry ? Section::Other : Section::Entry;
+                seenEntry = true;
+            } else if (startsWith(group, "Desktop Action ")) {
+                section = Section::Action;
+                actionGroups.append({ group.sliced(15), Group() });
+            } else {
+                section = Section::Other;
+            }
+            continue;
+        }
+        if (section == Section::Other) {
+            continue;
+        }
+
+        const char* equalsSign = find(line, '=');
+        if (!equalsSign) {
+            continue;
+        }
+        QByteArrayView key = trimmed(QByteArrayView(line.data(), equalsSign - line.data()));
+        const QByteArrayView value = trimmed(QByteArrayView(equalsSign + 1, line.data() + line.size() - equalsSign - 1));
+        if (key.isEmpty()) {
+            continue;
+        }
+
+        // Name[de_DE]=..., anything in a locale we dont run in is skipped right here
+        int rank = unlocalized;
+        const bool localized = key[key.size() - 1] == ']';
+        if (localized) {
+            const char* bracket = find(key, '[');
+            if (!bracket) {
+                continue;
+            }
+            rank = localeRank(QByteArrayView(bracket + 1, key.data() + key.size() - bracket - 2));
+            if (rank < 0) {
+                continue;
+            }
+            key = QByteArrayView(key.data(), bracket - key.data());
+        }
+
+        Group& group = section == Section::Entry ? entry : actionGroups.last().second;
+        group.assign(key, value, rank, localized);
+    }
+
+    if (!seenEntry) {
+        return std::nullopt;
+    }
+    if (!entry.type.isNull() && !equals(entry.type, "Application")) {
+        return std::nullopt;
+    }
+    if (isTrue(entry.noDisplay) || isTrue(entry.hidden)) {
+        return std::nullopt;
+    }
+
+    DesktopEntry result;
+    result.name = unescape(entry.name.value);
+    result.icon = unescape(entry.icon);
+    result.exec = expandExec(entry.exec, result.name, result.icon, path);
+    if (result.name.isEmpty() || result.exec.isEmpty()) {
+        return std::nullopt;
+    }
+    result.genericName = unescape(entry.genericName.value);
+    result.comment = unescape(entry.comment.value);
+    result.keywords = unescapeList(entry.keywords.value);
+    result.categories = unescapeList(entry.categories);
+
+    // only the actions the entry lists count, in the order it lists them
+    for (const QString& id : unescapeList(entry.actions)) {
+        for (const auto& [groupId, group] : std::as_const(actionGroups)) {
+            if (QString::fromUtf8(groupId) != id) {
+                continue;
+            }
+            DesktopAction action;
+            action.id = id;
+            action.name = unescape(group.name.value);
+            action.icon = group.icon.isNull() ? result.icon : unescape(group.icon);
+            action.exec = expandExec(group.exec, result.name, action.icon, path);
+            if (!action.name.isEmpty() && !action.exec.isEmpty()) {
+                result.actions.append(action);
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+QString DesktopEntryParser::unescape(const QByteArrayView raw) {
+    return unescaped(raw, false);
+}
+
+QStringList DesktopEntryParser::unescapeList(const QByteArrayView raw) {
+    QStringList items;
+    qsizetype start = 0;
+    for (qsizetype i = 0; i <= raw.size(); ++i) {
+        if (i < raw.size() && raw[i] == '\\') {
+            ++i;
+            continue;
+        }
+        if (i == raw.size() || raw[i] == ';') {
+            if (i > start) {
+                items.append(unescaped(raw.sliced(start, i - start), true));
+            }
+            start = i + 1;
+        }
+    }
+    return items;
+}
+
+QStringList DesktopEntryParser::splitExec(const QString& exec) {
+    // arguments are split on spaces, double quotes group them. inside quotes a backslash escapes " ` $ and \ itself
+    QStringList args;
+    QString current;
+    bool quoted = false;
+    bool hasArg = false;
+    for (qsizetype i = 0; i < exec.size(); ++i) {
+        const QChar c = exec[i];
+        if (quoted) {
+            if (c == '\\' && i + 1 < exec.size() && QStringView(u"\"`$\\").contains(exec[i + 1])) {
+                current += exec[++i];
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                current += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+            hasArg = true;
+        } else if (c == ' ' || c == '\t' || c == '\n') {
+            if (hasArg) {
+                args.append(current);
+                current.clear();
+                hasArg = false;
+            }
+        } else {
+            current += c;
+            hasArg = true;
+        }
+    }
+    if (hasArg) {
+        args.append(current);
+    }
+    return args;
+}
+
+QString DesktopEntryParser::joinCommand(const QStringList& args) {
+    // QProcess::splitCommand groups with double quotes and reads a tripled quote as a literal one
+    QStringList parts;
+    parts.reserve(args.size());
+    for (QString arg : args) {
+        const bool needsQuotes = arg.isEmpty() || arg.contains(' ') || arg.contains('\t') || arg.contains('\n');
+        arg.replace('"', "\"\"\"");
+        parts.append(needsQuotes ? '"' + arg + '"' : arg);
+    }
+    return parts.join(' ');
+}
+
+QString DesktopEntryParser::expandExec(const QByteArrayView raw, const QString& name, const QString& icon, const QString& path) {
+    // f - the file name
+    // F - multiple file names
+    // u - a single URL
+    // U - multiple URLs
+    // d - directory
+    // D - directory of first file
+    // n - file name without path
+    // N - multiple file names without paths
+    // v - device (eg. for mounting)
+    // m - mimetypes
+    // nothing gets opened through rnux, so all of those just go. what's left:
+    // i - icon, becomes "--icon <Icon>"
+    // c - translated name
+    // k - desktop file name
+    // %% - a literal %
+    QStringList args;
+    for (const QString& arg : splitExec(unescape(raw))) {
+        if (arg == "%i") {
+            if (!icon.isEmpty()) {
+                args << "--icon" << icon;
+            }
+            continue;
+        }
+
+        QString expanded;
+        expanded.reserve(arg.size());
+        for (qsizetype i = 0; i < arg.size(); ++i) {
+            if (arg[i] != '%' || i + 1 == arg.size()) {
+                expanded += arg[i];
+                continue;
+            }
+            switch (arg[++i].unicode()) {
+            case '%': expanded += '%'; break;
+            case 'c': expanded += name; break;
+            case 'k': expanded += path; break;
+            default: break;
+            }
+        }
+        // an argument that was nothing but field codes (%U) goes away completely
+        if (expanded.isEmpty() && !arg.isEmpty()) {
+            continue;
+        }
+        args.append(expanded);
+    }
+    return joinCommand(args);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <optional>
+
+// a [Desktop Action id] group, only the ones named in the entry's Actions= key
+struct DesktopAction {
+    QString id;
+    QString name;
+    QString icon; // falls back to the entry's icon
+    QString exec;
+};
+
+// what rnux needs out of a .desktop file. strings are unescaped and localized, exec has its
+// field codes expanded and is quoted so QProcess::splitCommand gets the original arguments back
+struct DesktopEntry {
+    QString name;
+    QString genericName;
+    QString comment;
+    QString icon;
+    QString exec;
+    QStringList keywords;
+    QStringList categories;
+    QList<DesktopAction> actions;
+};
+
+// reads .desktop files (freedesktop desktop entry spec 1.5) straight out of a mapping. one pass over the
+// bytes, only [Desktop Entry] and [Desktop Action] groups are looked at, and only the values that end up
+// being used get turned into QStrings. reentrant, one parser can be shared between threads
+class DesktopEntryParser {
+public:
+    // locale like LC_MESSAGES, "de_DE.UTF-8@euro". empty or "C" means only unlocalized keys are used
+    explicit DesktopEntryParser(const QByteArray& locale = systemLocale());
+
+    // nullopt for anything that shouldnt be listed (hidden, not an application, no name/exec)
+    [[nodiscard]] std::optional<DesktopEntry> parseFile(const QString& path) const;
+    // path is only used for the %k field code
+    [[nodiscard]] std::optional<DesktopEntry> parse(QByteArrayView data, const QString& path = {}) const;
+
+    static QByteArray systemLocale();
+    // \s \n \t \r \\ (and \; in lists)
+    static QString unescape(QByteArrayView raw);
+    static QStringList unescapeList(QByteArrayView raw);
+    // Exec= after unescape() -> arguments, honouring the spec's double quoting
+    static QStringList splitExec(const QString& exec);
+    // the reverse of QProcess::splitCommand
+    static QString joinCommand(const QStringList& args);
+
+private:
+    // how well a key's [locale] suffix fits, lower is better. -1 if it doesnt fit at all
+    [[nodiscard]] int localeRank(QByteArrayView locale) const;
+    static QString expandExec(QByteArrayView raw, const QString& name, const QString& icon, const QString& path);
+
+    // lang_COUNTRY@MODIFIER, lang_COUNTRY, lang@MODIFIER, lang, in the order the spec wants them tried
+    QList<QByteArray> m_locales;
+};
\ No newline at end of file
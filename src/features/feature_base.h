@@ -2,6 +2,11 @@
 
 #include <QIcon>
 #include <QList>
+#include <QStringList>
+#include <QRegularExpression>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <utility>
 
 struct FeatureItem {
@@ -10,6 +15,8 @@ struct FeatureItem {
     QString icon;
     QString data;
     QString type;
+    double score { 0.0 }; // relevance in [0, 1], comparable across features
+    QList<int> highlights; // indices into title the query matched, the ui marks them
 
     FeatureItem() = default;
     FeatureItem(QString  t, QString  s, QString  i, QString  d, QString  type)
@@ -20,16 +27,93 @@ struct FeatureItem {
                subtitle == other.subtitle &&
                icon == other.icon &&
                data == other.data &&
-               type == other.type;
+               type == other.type &&
+               score == other.score &&
+               highlights == other.highlights;
     }
 };
 
+// one dispatched query. every keystroke gets a new generation, once a newer one has been
+// dispatched the context is cancelled and anything still computing for it can bail out
+struct QueryContext {
+    QString query;
+    QString trigger;  // lowercased prefix the query was routed by, if any ("clip", "gh")
+    QString argument; // whatever follows the trigger and its space
+    quint64 generation { 0 };
+    std::shared_ptr<const std::atomic<quint64>> latestGeneration;
+
+    [[nodiscard]] bool isCancelled() const {
+        return latestGeneration && latestGeneration->load(std::memory_order_relaxed) != generation;
+    }
+};
+
+// what queries a feature can answer, so the router only sends it those
+struct FeatureTriggers {
+    // first words ("clip", "gh") that hand this feature the query split into trigger and argument
+    QStringList prefixes;
+    // "<prefix> ..." reaches this feature and nothing else, the general ones dont see it either
+    bool exclusive { false };
+    // never runs on a query without one of its prefixes
+    bool prefixOnly { false };
+    // a query that is just the prefix ("clip") also reaches the feature, next to the general ones
+    bool matchesBarePrefix { false };
+    // trimmed queries shorter than this are skipped
+    int minLength { 0 };
+    // if set, queries that dont match it are skipped
+    QRegularExpression shape;
+};
+
 class FeatureBase {
 public:
+    // receives a feature's full, updated result slice for a query it already answered in search()
+    using ResultPublisher = std::function<void(const QueryContext& context, const QList<FeatureItem>& results)>;
+
     virtual ~FeatureBase() = default;
     [[nodiscard]] virtual QString getName() const = 0;
     [[nodiscard]] virtual QString getIcon() const = 0;
-    virtual QList<FeatureItem> search(const QString& query) = 0;
+    virtual QList<FeatureItem> search(const QueryContext& context) = 0;
     virtual void execute(const FeatureItem& item) = 0;
     [[nodiscard]] virtual bool isEnabled() const { return true; }
+    // true if search() can run on a worker thread, only one search per feature is ever in flight
+    [[nodiscard]] virtual bool isThreadSafe() const { return false; }
+    // read once when the features are set up
+    [[nodiscard]] virtual FeatureTriggers triggers() const { return {}; }
+    // false if results depend on more than the query and dataVersion() (the clock, side effects in search())
+    [[nodiscard]] virtual bool isCacheable() const { return true; }
+    // search() goes over the network, these are always held back until typing pauses
+    [[nodiscard]] virtual bool isNetworked() const { return false; }
+    // how long one search() may take before the watchdog drops its results, ~/.rnux/budgets.ini can override it
+    [[nodiscard]] virtual int latencyBudgetMs() const { return 40; }
+    // bumped every time the data search() works on changes, memoized results for older versions are stale
+    [[nodiscard]] quint64 dataVersion() const { return m_dataVersion.load(std::memory_order_acquire); }
+
+    void setResultPublisher(ResultPublisher publisher) { m_publisher = std::move(publisher); }
+
+    // runs buildIndex() once, on a worker thread after startup. the dispatcher doesn't send the
+    // feature any queries until it's ready
+    void initialize() {
+        buildIndex();
+        m_ready.store(true, std::memory_order_release);
+    }
+    [[nodiscard]] bool isReady() const { return m_ready.load(std::memory_order_acquire); }
+
+protected:
+    // the slow part of starting up (scanning, loading and decrypting files). constructors should stay
+    // cheap, the window and tray icon wait on them. anything that needs the gui thread has to be queued from here
+    virtual void buildIndex() {}
+
+    void invalidateResults() { m_dataVersion.fetch_add(1, std::memory_order_release); }
+
+    // search() returns what it has right away, anything that shows up later (network replies etc.)
+    // is pushed through here. safe to call from any thread
+    void publishResults(const QueryContext& context, const QList<FeatureItem>& results) const {
+        if (m_publisher && !context.isCancelled()) {
+            m_publisher(context, results);
+        }
+    }
+
+private:
+    ResultPublisher m_publisher;
+    std::atomic<quint64> m_dataVersion { 0 };
+    std::atomic<bool> m_ready { false };
 };
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "fuzzy_index.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RNUX_X86 1
+#endif
+
+namespace {
+
+using FindKernel = qsizetype (*)(const char16_t* text, qsizetype length, char16_t c);
+
+qsizetype findScalar(const char16_t* text, const qsizetype length, const char16_t c) {
+    for (qsizetype i = 0; i < length; ++i) {
+        if (text[i] == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef __SSE2__
+// 8 chars per compare, movemask gives 2 bits per char so the lane is ctz / 2
+qsizetype findSse2(const char16_t* text, const qsizetype length, const char16_t c) {
+    const __m128i needle = _mm_set1_epi16(static_cast<short>(c));
+    qsizetype i = 0;
+    for (; i + 8 <= length; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        if (const int bits = _mm_movemask_epi8(_mm_cmpeq_epi16(chunk, needle))) {
+            return i + (__builtin_ctz(static_cast<unsigned>(bits)) >> 1);
+        }
+    }
+    const qsizetype rest = findScalar(text + i, length - i, c);
+    return rest < 0 ? -1 : i + rest;
+}
+#endif
+
+#ifdef RNUX_X86
+// built for avx2 on its own, the rest of the binary stays baseline x86-64
+__attribute__((target("avx2")))
+qsizetype findAvx2(const char16_t* text, const qsizetype length, const char16_t c) {
+    const __m256i needle = _mm256_set1_epi16(static_cast<short>(c));
+    qsizetype i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        if (const int bits = _mm256_movemask_epi8(_mm256_cmpeq_epi16(chunk, needle))) {
+            return i + (__builtin_ctz(static_cast<unsigned>(bits)) >> 1);
+        }
+    }
+    // most titles are shorter than 16 chars, one 8 wide step before going scalar
+    if (i + 8 <= length) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        if (const int bits = _mm_movemask_epi8(_mm_cmpeq_epi16(chunk, _mm256_castsi256_si128(needle)))) {
+            return i + (__builtin_ctz(static_cast<unsigned>(bits)) >> 1);
+        }
+        i += 8;
+    }
+    const qsizetype rest = findScalar(text + i, length - i, c);
+    return rest < 0 ? -1 : i + rest;
+}
+#endif
+
+struct Kernel {
+    FindKernel find;
+    const char* name;
+};
+
+Kernel pickKernel() {
+#ifdef RNUX_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return { findAvx2, "avx2" };
+    }
+#endif
+#ifdef __SSE2__
+    return { findSse2, "sse2" };
+#else
+    return { findScalar, "scalar" };
+#endif
+}
+
+const Kernel KERNEL = pickKernel();
+
+const char16_t* chars(const QStringView text) {
+    return reinterpret_cast<const char16_t*>(text.utf16());
+}
+
+quint64 bitFor(const char16_t c) {
+    if (c >= 'a' && c <= 'z') {
+        return 1ULL << (c - 'a');
+    }
+    if (c >= '0' && c <= '9') {
+        return 1ULL << (26 + c - '0');
+    }
+    // everything else shares the top 28 bits, a collision only means a wasted scan
+    return 1ULL << (36 + c % 28);
+}
+
+} // namespace
+
+FuzzyIndex::FuzzyIndex(const QStringList& texts) {
+    m_offsets.reserve(texts.size() + 1);
+    m_masks.reserve(texts.size());
+    for (const QString& text : texts) {
+        const QString folded = text.toLower();
+        m_folded.append(folded);
+        m_offsets.append(m_folded.size());
+        m_masks.append(maskOf(folded));
+    }
+}
+
+FuzzyIndex::Query FuzzyIndex::prepare(const QString& query) {
+    Query prepared;
+    prepared.folded = query.toLower();
+    prepared.mask = maskOf(prepared.folded);
+    return prepared;
+}
+
+bool FuzzyIndex::subsequence(const qsizetype entry, const Query& query, int* positions) const {
+    return mayMatch(entry, query) && subsequence(text(entry), query.folded, positions);
+}
+
+bool FuzzyIndex::contains(const qsizetype entry, const Query& query) const {
+    return mayMatch(entry, query) && contains(text(entry), query.folded);
+}
+
+bool FuzzyIndex::subsequence(const QStringView text, const QStringView query, int* positions) {
+    const char16_t* data = chars(text);
+    const char16_t* needle = chars(query);
+    qsizetype from = 0;
+    for (qsizetype q = 0; q < query.size(); ++q) {
+        // fewer chars left than the query still needs
+        if (query.size() - q > text.size() - from) {
+            return false;
+        }
+        const qsizetype at = KERNEL.find(data + from, text.size() - from, needle[q]);
+        if (at < 0) {
+            return false;
+        }
+        positions[q] = static_cast<int>(from + at);
+        from += at + 1;
+    }
+    return true;
+}
+
+bool FuzzyIndex::contains(const QStringView text, const QStringView query) {
+    if (query.isEmpty()) {
+        return true;
+    }
+
+    const char16_t* data = chars(text);
+    const char16_t* needle = chars(query);
+    const qsizetype tail = (query.size() - 1) * static_cast<qsizetype>(sizeof(char16_t));
+    qsizetype from = 0;
+    while (text.size() - from >= query.size()) {
+        // only look for the first char where the whole query still fits
+        const qsizetype at = KERNEL.find(data + from, text.size() - from - query.size() + 1, needle[0]);
+        if (at < 0) {
+            return false;
+        }
+        if (std::memcmp(data + from + at + 1, needle + 1, tail) == 0) {
+            return true;
+        }
+        from += at + 1;
+    }
+    return false;
+}
+
+quint64 FuzzyIndex::maskOf(const QStringView folded) {
+    quint64 mask = 0;
+    for (const QChar c : folded) {
+        mask |= bitFor(c.unicode());
+    }
+    return mask;
+}
+
+const char* FuzzyIndex::kernel() {
+    return KERNEL.name;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QList>
+#include <QtAlgorithms>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+// a list of strings prepared for matching: each one lowercased once into a single contiguous utf-16
+// buffer, plus a 64 bit mask of the characters it contains. a query gets the same mask, so an entry
+// missing one of the query's characters is thrown out with one AND before anything is scanned.
+// the scans themselves go through an sse2/avx2 "find the next c" kernel, picked once at startup
+class FuzzyIndex {
+public:
+    // a query folded and masked once per search
+    struct Query {
+        QString folded;
+        quint64 mask { 0 };
+    };
+
+    FuzzyIndex() = default;
+    explicit FuzzyIndex(const QStringList& texts);
+
+    static Query prepare(const QString& query);
+
+    [[nodiscard]] qsizetype size() const { return m_masks.size(); }
+    // the lowercased entry, same length and indices as the original unless lowercasing changed its length
+    [[nodiscard]] QStringView text(const qsizetype entry) const {
+        return QStringView(m_folded).sliced(m_offsets[entry], m_offsets[entry + 1] - m_offsets[entry]);
+    }
+    [[nodiscard]] bool mayMatch(const qsizetype entry, const Query& query) const {
+        return (m_masks[entry] & query.mask) == query.mask;
+    }
+    // how many of the query's characters (by mask bit) the entry doesnt have at all. each one costs a
+    // typo, so it bounds the edit distance from below
+    [[nodiscard]] int missing(const qsizetype entry, const Query& query) const {
+        return qPopulationCount(query.mask & ~m_masks[entry]);
+    }
+
+    // every query char in order, each at its first occurrence after the previous one. positions gets
+    // query.folded.size() indices into text(entry)
+    [[nodiscard]] bool subsequence(qsizetype entry, const Query& query, int* positions) const;
+    [[nodiscard]] bool contains(qsizetype entry, const Query& query) const;
+
+    // the same on plain strings, both sides have to be folded already
+    static bool subsequence(QStringView text, QStringView query, int* positions);
+    static bool contains(QStringView text, QStringView query);
+
+    static quint64 maskOf(QStringView folded);
+    // "avx2", "sse2" or "scalar"
+    static const char* kernel();
+
+private:
+    QString m_folded;
+    QList<qsizetype> m_offsets { 0 }; // entry i is [m_offsets[i], m_offsets[i + 1])
+    QList<quint64> m_masks;
+};
\ No newline at end of file
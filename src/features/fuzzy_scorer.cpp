@@ -0,0 +1,205 @@
+#include "fuzzy_scorer.h"
+#include "fuzzy_index.h"
+#include <QVarLengthArray>
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+enum class CharClass { White, Delimiter, NonWord, Lower, Upper, Letter, Number };
+
+constexpr int NONE = INT_MIN / 2;
+
+CharClass classOf(const QChar c) {
+    if (c.isLower()) return CharClass::Lower;
+    if (c.isUpper()) return CharClass::Upper;
+    if (c.isDigit()) return CharClass::Number;
+    if (c.isLetter()) return CharClass::Letter;
+    if (c.isSpace()) return CharClass::White;
+    if (QStringView(u"/,:;|-_.").contains(c)) return CharClass::Delimiter;
+    return CharClass::NonWord;
+}
+
+bool isWord(const CharClass c) {
+    return c > CharClass::NonWord;
+}
+
+// what matching a char of class current right after one of class previous is worth
+int bonusFor(const CharClass previous, const CharClass current) {
+    if (isWord(current)) {
+        if (previous == CharClass::White) return FuzzyScorer::BONUS_BOUNDARY_WHITE;
+        if (previous == CharClass::Delimiter) return FuzzyScorer::BONUS_BOUNDARY_DELIMITER;
+        if (previous == CharClass::NonWord) return FuzzyScorer::BONUS_BOUNDARY;
+    }
+    if ((previous == CharClass::Lower && current == CharClass::Upper) ||
+        (previous != CharClass::Number && current == CharClass::Number)) {
+        return FuzzyScorer::BONUS_CAMEL_123;
+    }
+    if (current == CharClass::White) return FuzzyScorer::BONUS_BOUNDARY_WHITE;
+    if (!isWord(current)) return FuzzyScorer::BONUS_NON_WORD;
+    return 0;
+}
+
+// bonus[j] is what matching folded[j] is worth by itself. case only survives in the original, the
+// folded text stands in if lowercasing changed the length
+void fillBonuses(const QStringView text, const QStringView folded, int* bonus) {
+    const QStringView shape = text.size() == folded.size() ? text : folded;
+    CharClass previous = CharClass::White;
+    for (qsizetype j = 0; j < folded.size(); ++j) {
+        const CharClass current = classOf(shape[j]);
+        bonus[j] = bonusFor(previous, current);
+        previous = current;
+    }
+}
+
+// the score of one particular alignment, used when the text is too long for the dp
+int scoreAlong(const int* bonus, const int* positions, const qsizetype count) {
+    int score = 0;
+    int runStart = 0;
+    for (qsizetype i = 0; i < count; ++i) {
+        const int at = positions[i];
+        if (i == 0) {
+            score += FuzzyScorer::SCORE_MATCH + bonus[at] * FuzzyScorer::FIRST_CHAR_MULTIPLIER;
+            runStart = bonus[at];
+        } else if (at == positions[i - 1] + 1) {
+            if (bonus[at] >= FuzzyScorer::BONUS_BOUNDARY && bonus[at] > runStart) runStart = bonus[at];
+            score += FuzzyScorer::SCORE_MATCH + std::max({ bonus[at], runStart, FuzzyScorer::BONUS_CONSECUTIVE });
+        } else {
+            const int gap = at - positions[i - 1] - 1;
+            score += FuzzyScorer::SCORE_MATCH + bonus[at] + FuzzyScorer::GAP_START + FuzzyScorer::GAP_EXTENSION * (gap - 1);
+            runStart = bonus[at];
+        }
+    }
+    return score;
+}
+
+} // namespace
+
+std::optional<int> FuzzyScorer::score(const QStringView text, const QStringView folded, const QStringView query, int* positions) {
+    const qsizetype n = folded.size();
+    const qsizetype m = query.size();
+    if (m == 0) {
+        return 0;
+    }
+    // first[i] is the leftmost column query[i] can take
+    QVarLengthArray<int, 32> first(m);
+    if (!FuzzyIndex::subsequence(folded, query, first.data())) {
+        return std::nullopt;
+    }
+
+    QVarLengthArray<int, 64> bonus(n);
+    fillBonuses(text, folded, bonus.data());
+
+    if (n > MAX_TEXT || m > MAX_QUERY) {
+        std::copy(first.begin(), first.end(), positions);
+        return scoreAlong(bonus.data(), positions, m);
+    }
+
+    // and last[i] the rightmost, from matching right to left
+    QVarLengthArray<int, 32> last(m);
+    for (qsizetype i = m - 1, j = n - 1; i >= 0; --i, --j) {
+        while (folded[j] != query[i]) --j;
+        last[i] = static_cast<int>(j);
+    }
+
+    // row i only has the columns [first[i], last[i]]
+    QVarLengthArray<int, 33> offset(m + 1);
+    offset[0] = 0;
+    for (qsizetype i = 0; i < m; ++i) {
+        offset[i + 1] = offset[i] + last[i] - first[i] + 1;
+    }
+    const auto cell = [&](const qsizetype i, const int j) { return offset[i] + j - first[i]; };
+
+    // best score with query[i] matched exactly at column j, the bonus its run of consecutive matches
+    // started with, and the column query[i - 1] sits at on that path.
+    // keeping only the best path per cell ignores that a lower score with a better run bonus could
+    // still win later, same as fzf does. that costs a few points on rare inputs
+    QVarLengthArray<int, 256> best(offset[m]);
+    QVarLengthArray<int, 256> run(offset[m]);
+    QVarLengthArray<int, 256> from(offset[m]);
+
+    for (int j = first[0]; j <= last[0]; ++j) {
+        const int c = cell(0, j);
+        if (folded[j] != query[0]) {
+            best[c] = NONE;
+            continue;
+        }
+        best[c] = SCORE_MATCH + bonus[j] * FIRST_CHAR_MULTIPLIER;
+        run[c] = bonus[j];
+        from[c] = -1;
+    }
+
+    for (qsizetype i = 1; i < m; ++i) {
+        const int previousFirst = first[i - 1];
+        const int previousLast = last[i - 1];
+        const auto previousBest = [&](const int k) {
+            return k >= previousFirst && k <= previousLast ? best[cell(i - 1, k)] : NONE;
+        };
+
+        // best way to arrive at column j after skipping at least one char, every candidate pays one
+        // more GAP_EXTENSION per step so only the new one has to be compared
+        int gap = NONE;
+        int gapFrom = -1;
+        for (int j = previousFirst + 1; j <= last[i]; ++j) {
+            if (gap > NONE) gap += GAP_EXTENSION;
+            if (const int skipped = previousBest(j - 2); skipped > NONE && skipped + GAP_START > gap) {
+                gap = skipped + GAP_START;
+                gapFrom = j - 2;
+            }
+            if (j < first[i]) continue;
+
+            const int c = cell(i, j);
+            if (folded[j] != query[i]) {
+                best[c] = NONE;
+                continue;
+            }
+            int score = NONE;
+            int runStart = bonus[j];
+            int previousColumn = -1;
+            if (const int adjacent = previousBest(j - 1); adjacent > NONE) {
+                int start = run[cell(i - 1, j - 1)];
+                if (bonus[j] >= BONUS_BOUNDARY && bonus[j] > start) start = bonus[j];
+                score = adjacent + SCORE_MATCH + std::max({ bonus[j], start, BONUS_CONSECUTIVE });
+                runStart = start;
+                previousColumn = j - 1;
+            }
+            if (gap > NONE && gap + SCORE_MATCH + bonus[j] > score) {
+                score = gap + SCORE_MATCH + bonus[j];
+                runStart = bonus[j];
+                previousColumn = gapFrom;
+            }
+            best[c] = score;
+            run[c] = runStart;
+            from[c] = previousColumn;
+        }
+    }
+
+    // ties go to the leftmost end
+    int end = -1;
+    int total = NONE;
+    for (int j = first[m - 1]; j <= last[m - 1]; ++j) {
+        if (best[cell(m - 1, j)] > total) {
+            total = best[cell(m - 1, j)];
+            end = j;
+        }
+    }
+    for (qsizetype i = m - 1; i >= 0; --i) {
+        positions[i] = end;
+        end = from[cell(i, end)];
+    }
+    return total;
+}
+
+int FuzzyScorer::alignmentScore(const QStringView text, const QStringView folded, const int* positions, const qsizetype count) {
+    QVarLengthArray<int, 64> bonus(folded.size());
+    fillBonuses(text, folded, bonus.data());
+    return scoreAlong(bonus.data(), positions, count);
+}
+
+int FuzzyScorer::prefixScore(const qsizetype queryLength) {
+    if (queryLength <= 0) {
+        return 1;
+    }
+    return SCORE_MATCH + BONUS_BOUNDARY_WHITE * FIRST_CHAR_MULTIPLIER +
+           static_cast<int>(queryLength - 1) * (SCORE_MATCH + BONUS_BOUNDARY_WHITE);
+}
\ No newline at end of file
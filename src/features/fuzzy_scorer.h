@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QStringView>
+#include <optional>
+
+// fzf style scoring for a query that is known to be a subsequence of a text: of all the ways the query
+// can be laid over the text, pick the one that scores best instead of the first one found. matches
+// after a space, a delimiter or at a camelCase/digit hump earn a bonus, runs of consecutive matches
+// keep the bonus their run started with, and gaps cost a little for opening and less for each extra char.
+//
+// the dp only looks at columns a query char can actually land on: between where the greedy left to
+// right match puts it and where a right to left one does. for typical titles that band is a handful of
+// columns per query char, so this is barely more work than the greedy scan
+class FuzzyScorer {
+public:
+    static constexpr int SCORE_MATCH = 16;
+    static constexpr int GAP_START = -3;
+    static constexpr int GAP_EXTENSION = -1;
+    static constexpr int BONUS_BOUNDARY = SCORE_MATCH / 2;
+    static constexpr int BONUS_BOUNDARY_WHITE = BONUS_BOUNDARY + 2;
+    static constexpr int BONUS_BOUNDARY_DELIMITER = BONUS_BOUNDARY + 1;
+    static constexpr int BONUS_NON_WORD = SCORE_MATCH / 2;
+    static constexpr int BONUS_CAMEL_123 = BONUS_BOUNDARY + GAP_EXTENSION;
+    static constexpr int BONUS_CONSECUTIVE = -(GAP_START + GAP_EXTENSION);
+    static constexpr int FIRST_CHAR_MULTIPLIER = 2;
+
+    // anything bigger is scored along the greedy match instead of running the dp
+    static constexpr qsizetype MAX_TEXT = 256;
+    static constexpr qsizetype MAX_QUERY = 32;
+
+    // text is what gets shown (its case is what makes camelCase humps), folded is its lowercased form and
+    // query is folded too. positions gets query.size() indices into folded. nullopt if query isnt a subsequence
+    static std::optional<int> score(QStringView text, QStringView folded, QStringView query, int* positions);
+    // what one particular alignment scores, positions being count ascending indices into folded.
+    // score() is the best of these, up to the paths its dp drops
+    static int alignmentScore(QStringView text, QStringView folded, const int* positions, qsizetype count);
+    // what a query of this length scores as a prefix of a title, about the best it does in practice
+    static int prefixScore(qsizetype queryLength);
+};
\ No newline at end of file
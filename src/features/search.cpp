@@ -9,26 +9,31 @@
 #include <QDateTime>
 #include <QMutexLocker>
 #include <QDebug>
+#include <QTimer>
 
 Search::Search(QObject* parent)
     : QObject(parent)
     , m_networkManager(new QNetworkAccessManager(this))
-    , m_searchTimer(new QTimer(this))
 {
+    // the providers are needed right away for triggers(), the cache and icons come later in buildIndex
     setupProviders();
-    initializeCache();
-    downloadProviderIcons();
-
-    m_searchTimer->setSingleShot(true);
-    m_searchTimer->setInterval(200);
-    connect(m_searchTimer, &QTimer::timeout, this, &Search::onSearchTimeout);
 }
 
 Search::~Search() {
-    if (m_currentReply) {
-        m_currentReply->abort();
+    for (const auto& pending : m_pendingReplies) {
+        pending.reply->disconnect(this);
+        pending.reply->abort();
+    }
+    // an unloaded cache would overwrite the one on disk with nothing
+    if (isReady()) {
+        saveCache();
     }
-    saveCache();
+}
+
+void Search::buildIndex() {
+    initializeCache();
+    // the network manager lives on the gui thread
+    QMetaObject::invokeMethod(this, &Search::downloadProviderIcons, Qt::QueuedConnection);
 }
 
 void Search::setupProviders() {
@@ -112,6 +117,10 @@ void Search::setupProviders() {
                       "https://twitter.com/search?q=%1",
                       "Search Twitter"),
     };
+
+    for (qsizetype i = 0; i < m_providers.size(); ++i) {
+        m_providerIndex.insert(m_providers[i].shortcut, i);
+    }
 }
 
 void Search::downloadProviderIcons() {
@@ -164,40 +173,57 @@ void Search::onIconDownloaded() {
     reply->deleteLater();
 }
 
-QList<FeatureItem> Search::search(const QString& query) {
-    QList<FeatureItem> results;
-    if (query.isEmpty()) return results;
+const SearchProvider* Search::providerFor(const QString& shortcut) const {
+    const auto it = m_providerIndex.constFind(shortcut);
+    return it == m_providerIndex.constEnd() ? nullptr : &m_providers[*it];
+}
 
+FeatureItem Search::providerItem(const SearchProvider& provider, const QString& searchQuery) const {
+    const QString iconPath = m_iconPaths.value(provider.shortcut, "system-search");
+    FeatureItem item;
+    if (searchQuery.isEmpty()) {
+        item = { provider.name, "", iconPath,
+                 provider.searchUrl.arg(""), "search" };
+    } else {
+        item = { QString("Search %1: %2").arg(provider.name, searchQuery),
+                 "", iconPath,
+                 provider.searchUrl.arg(QString(QUrl::toPercentEncoding(searchQuery))),
+                 "search" };
+    }
+    // the shortcut was typed on purpose, so this goes above anything fuzzy matched
+    item.score = 0.95;
+    return item;
+}
+
+FeatureTriggers Search::triggers() const {
+    FeatureTriggers triggers;
     for (const auto& provider : m_providers) {
-        if (QString pattern = provider.shortcut + " "; query.startsWith(pattern, Qt::CaseInsensitive)) {
-            if (QString searchQuery = extractSearchQuery(query, provider.shortcut); searchQuery.isEmpty()) {
-                const QString iconPath = m_iconPaths.value(provider.shortcut, "system-search");
-                results.append({ provider.name, "", iconPath,
-                                 provider.searchUrl.arg(""), "search" });
-            } else {
-                const QString iconPath = m_iconPaths.value(provider.shortcut, "system-search");
-                results.append({ QString("Search %1: %2").arg(provider.name, searchQuery),
-                                 "", iconPath,
-                                 provider.searchUrl.arg(QString(QUrl::toPercentEncoding(searchQuery))),
-                                 "search" });
-
-                // check cache for the thingies that fetch the things from the thingies api
-                if (provider.hasApi && !provider.cacheType.isEmpty()) {
-                    if (const QList<FeatureItem> cachedResults = getCachedResults(provider.cacheType, searchQuery); !cachedResults.isEmpty()) {
-                        results.append(cachedResults);
-                        return results;
-                    }
-
-                    // trigger search through api
-                    if (m_currentQuery != query) {
-                        m_currentQuery = query;
-                        m_activeSearchType = provider.cacheType;
-                        m_activeSearchQuery = searchQuery;
-                        m_searchTimer->start();
-                    }
-                }
-            }
-            break;
+        triggers.prefixes.append(provider.shortcut);
+    }
+    triggers.prefixOnly = true;
+    return triggers;
+}
+
+QList<FeatureItem> Search::search(const QueryContext& context) {
+    QList<FeatureItem> results;
+
+    // the router only sends "<shortcut> ..." queries, the trigger is the shortcut
+    const SearchProvider* provider = providerFor(context.trigger);
+    if (!provider) return results;
+
+    const QString searchQuery = context.argument.trimmed();
+    results.append(providerItem(*provider, searchQuery));
+
+    // check cache for the thingies that fetch the things from the thingies api
+    if (!searchQuery.isEmpty() && provider->hasApi && !provider->cacheType.isEmpty()) {
+        if (const QList<FeatureItem> cachedResults = getCachedResults(provider->cacheType, searchQuery); !cachedResults.isEmpty()) {
+            results.append(cachedResults);
+            return results;
+        }
+
+        // the dispatcher only gets here once typing paused, the results get published once the reply is in
+        if (!context.isCancelled()) {
+            performApiSearch(*provider, searchQuery, context);
         }
     }
     return results;
@@ -209,28 +235,21 @@ void Search::execute(const FeatureItem& item) {
     }
 }
 
-QString Search::extractSearchQuery(const QString& fullQuery, const QString& shortcut) {
-    if (const QString pattern = shortcut + " "; fullQuery.startsWith(pattern, Qt::CaseInsensitive)) {
-        return fullQuery.mid(pattern.length()).trimmed();
-    }
-    return {};
-}
-
-void Search::onSearchTimeout() {
-    for (const auto& provider : m_providers) {
-        if (QString pattern = provider.shortcut + " "; m_currentQuery.startsWith(pattern, Qt::CaseInsensitive)) {
-            if (const QString q = extractSearchQuery(m_currentQuery, provider.shortcut); !q.isEmpty() && provider.hasApi) {
-                performApiSearch(provider, q);
-            }
-            break;
+void Search::performApiSearch(const SearchProvider& provider, const QString& query, const QueryContext& context) {
+    // the same request is already on its way
+    for (auto& pending : m_pendingReplies) {
+        if (pending.cacheType == provider.cacheType && pending.searchQuery == query) {
+            pending.context = context;
+            return;
         }
     }
-}
 
-void Search::performApiSearch(const SearchProvider& provider, const QString& query) {
-    if (m_currentReply) {
-        m_currentReply->abort();
-        m_currentReply = nullptr;
+    // older requests are left running so their results still end up in the cache, up to a point
+    if (m_pendingReplies.size() >= MAX_PENDING_REPLIES) {
+        QNetworkReply* oldest = m_pendingReplies.takeFirst().reply;
+        oldest->disconnect(this);
+        oldest->abort();
+        oldest->deleteLater();
     }
 
     const QString apiUrl = provider.apiUrl.arg(QString(QUrl::toPercentEncoding(query)));
@@ -240,38 +259,48 @@ void Search::performApiSearch(const SearchProvider& provider, const QString& que
     if (provider.shortcut == "gh")
         request.setRawHeader("Accept", "application/vnd.github.v3+json");
 
-    m_currentReply = m_networkManager->get(request);
-    connect(m_currentReply, &QNetworkReply::finished, this, &Search::onApiResponse);
+    QNetworkReply* reply = m_networkManager->get(request);
+    m_pendingReplies.append({ reply, context, provider.cacheType, query });
+    connect(reply, &QNetworkReply::finished, this, &Search::onApiResponse);
 }
 
 void Search::onApiResponse() {
-    if (!m_currentReply) return;
-    QNetworkReply* reply = m_currentReply;
-    m_currentReply = nullptr;
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply) return;
 
-    if (reply->error() == QNetworkReply::NoError) {
+    PendingReply pending;
+    for (qsizetype i = 0; i < m_pendingReplies.size(); ++i) {
+        if (m_pendingReplies[i].reply == reply) {
+            pending = m_pendingReplies.takeAt(i);
+            break;
+        }
+    }
+
+    if (pending.reply && reply->error() == QNetworkReply::NoError) {
         const QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+        const QString& cacheType = pending.cacheType;
+        const QString& searchQuery = pending.searchQuery;
         QList<FeatureItem> results;
 
-        if (const QString urlStr = reply->url().toString(); urlStr.contains("registry.npmjs.org")) {
-            results = parseNpmResults(doc, m_activeSearchQuery);
-            if (!results.isEmpty()) {
-                setCachedResults("npm", m_activeSearchQuery, results);
-            }
-        } else if (urlStr.contains("crates.io/api")) {
-            results = parseCargoResults(doc, m_activeSearchQuery);
-            if (!results.isEmpty()) {
-                setCachedResults("cargo", m_activeSearchQuery, results);
-            }
-        } else if (urlStr.contains("api.github.com")) {
-            results = parseGitHubResults(doc, m_activeSearchQuery);
-            if (!results.isEmpty()) {
-                setCachedResults("github", m_activeSearchQuery, results);
-            }
+        if (cacheType == "npm") {
+            results = parseNpmResults(doc, searchQuery);
+        } else if (cacheType == "cargo") {
+            results = parseCargoResults(doc, searchQuery);
+        } else if (cacheType == "github") {
+            results = parseGitHubResults(doc, searchQuery);
         }
 
-        m_currentResults = results;
-        emit resultsUpdated();
+        if (!results.isEmpty()) {
+            setCachedResults(cacheType, searchQuery, results);
+        }
+
+        // cached either way, so backspacing to a superseded query is instant. only published if
+        // the query is still the one on screen, publishResults drops cancelled contexts
+        const QueryContext& context = pending.context;
+        if (const SearchProvider* provider = providerFor(context.trigger)) {
+            results.prepend(providerItem(*provider, searchQuery));
+        }
+        publishResults(context, results);
     }
     reply->deleteLater();
 }
@@ -479,5 +508,7 @@ QString Search::getCacheFilePath() {
 }
 
 FeatureItem Search::createFeatureItem(const QString& name, const QString& url) {
-    return FeatureItem{ name, "", "applications-development", url, "search" };
+    FeatureItem item{ name, "", "applications-development", url, "search" };
+    item.score = 0.9;
+    return item;
 }
\ No newline at end of file
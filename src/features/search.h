@@ -2,7 +2,6 @@
 
 #include "feature_base.h"
 #include <QtNetwork/QNetworkReply>
-#include <QTimer>
 #include <QJsonArray>
 #include <QDesktopServices>
 #include <QStandardPaths>
@@ -34,6 +33,13 @@ struct SearchProvider {
     {}
 };
 
+struct PendingReply {
+    QNetworkReply* reply { nullptr };
+    QueryContext context;
+    QString cacheType;
+    QString searchQuery;
+};
+
 struct CacheEntry {
     QString type;
     QString query;
@@ -54,22 +60,28 @@ public:
 
     [[nodiscard]] QString getName() const override { return "Search"; }
     [[nodiscard]] QString getIcon() const override { return "system-search"; }
-    QList<FeatureItem> search(const QString& query) override;
+    // search() starts the api request, skipping it on a cache hit would leave the results stuck
+    [[nodiscard]] bool isCacheable() const override { return false; }
+    [[nodiscard]] bool isNetworked() const override { return true; }
+    [[nodiscard]] FeatureTriggers triggers() const override;
+    QList<FeatureItem> search(const QueryContext& context) override;
     void execute(const FeatureItem& item) override;
 
-signals:
-    void resultsUpdated();
+protected:
+    void buildIndex() override;
 
 private slots:
     void onApiResponse();
-    void onSearchTimeout();
     void onIconDownloaded();
 
 private:
+    friend struct BenchAccess; // src/bench
+
     void setupProviders();
-    void performApiSearch(const SearchProvider& provider, const QString& query);
+    void performApiSearch(const SearchProvider& provider, const QString& query, const QueryContext& context);
     void downloadProviderIcons();
-    static QString extractSearchQuery(const QString& fullQuery, const QString& shortcut);
+    [[nodiscard]] const SearchProvider* providerFor(const QString& shortcut) const;
+    [[nodiscard]] FeatureItem providerItem(const SearchProvider& provider, const QString& searchQuery) const;
     static QList<FeatureItem> parseNpmResults(const QJsonDocument& doc, const QString& query);
     static QList<FeatureItem> parseCargoResults(const QJsonDocument& doc, const QString& query);
     static QList<FeatureItem> parseGitHubResults(const QJsonDocument& doc, const QString& query);
@@ -77,11 +89,10 @@ private:
     static FeatureItem createFeatureItem(const QString& name, const QString& url);
 
     QNetworkAccessManager* m_networkManager;
-    QTimer* m_searchTimer;
     QList<SearchProvider> m_providers;
-    QList<FeatureItem> m_currentResults;
-    QString m_currentQuery;
-    QNetworkReply* m_currentReply { nullptr };
+    QHash<QString, qsizetype> m_providerIndex; // shortcut -> m_providers
+    QList<PendingReply> m_pendingReplies;
+    static constexpr int MAX_PENDING_REPLIES = 4;
 
     // cache
     void initializeCache();
@@ -96,9 +107,6 @@ private:
     static constexpr int MAX_CACHE_ENTRIES = 250;
     static constexpr int CACHE_EXPIRE_HOURS = 24;
 
-    QString m_activeSearchType;
-    QString m_activeSearchQuery;
-
     QHash<QString, QPixmap> m_iconCache;
     QHash<QString, QString> m_iconPaths;
 };
\ No newline at end of file
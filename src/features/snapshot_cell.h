@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QMutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+
+// holds the current version of some index as an immutable, refcounted snapshot. readers grab a
+// shared_ptr to whatever is current without locking, writers build a whole new version and swap it in
+// (rcu style). a search keeps the snapshot it started on alive for as long as it needs it.
+//
+// shared_ptr can't be swapped atomically without a lock (std::atomic_load on it takes one), so the
+// current shared_ptr sits in a heap box and only the box pointer is atomic. a reader registers on the
+// counter of the epoch it saw before touching the box, a writer flips the epoch after swapping the box
+// and waits for the old epoch's readers to leave before freeing the old box. readers only stay
+// registered for the length of one refcount increment, so that wait is a few spins at most
+template <typename T>
+class SnapshotCell {
+public:
+    using Ptr = std::shared_ptr<const T>;
+
+    explicit SnapshotCell(Ptr initial = std::make_shared<const T>())
+        : m_current(new Ptr(std::move(initial))) {}
+
+    ~SnapshotCell() { delete m_current.load(); }
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    // never blocks, safe from any thread
+    [[nodiscard]] Ptr load() const {
+        // seq_cst on the counters and the epoch: either the writer sees this reader registered, or
+        // this reader sees the new epoch and tries again on the other counter
+        for (;;) {
+            const quint32 epoch = m_epoch.load();
+            std::atomic<quint32>& readers = m_readers[epoch & 1];
+            readers.fetch_add(1);
+            if (m_epoch.load() != epoch) {
+                readers.fetch_sub(1, std::memory_order_release);
+                continue;
+            }
+            Ptr snapshot = *m_current.load(std::memory_order_acquire);
+            readers.fetch_sub(1, std::memory_order_release);
+            return snapshot;
+        }
+    }
+
+    // safe from any thread, writers are serialized among themselves but never wait on a search
+    void store(Ptr next) {
+        auto* box = new Ptr(std::move(next));
+        QMutexLocker locker(&m_writeLock);
+        const Ptr* old = m_current.exchange(box, std::memory_order_acq_rel);
+        const quint32 epoch = m_epoch.load(std::memory_order_relaxed);
+        m_epoch.store(epoch + 1);
+        while (m_readers[epoch & 1].load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+        locker.unlock();
+        // the snapshot itself lives on in any search still holding it
+        delete old;
+    }
+
+private:
+    std::atomic<const Ptr*> m_current;
+    std::atomic<quint32> m_epoch { 0 };
+    mutable std::atomic<quint32> m_readers[2] { {0}, {0} };
+    QMutex m_writeLock;
+};
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "system_commands.h"
+#include "fuzzy_scorer.h"
+#include <QVarLengthArray>
 #include <algorithm>
 
 SystemCommands::SystemCommands() {
@@ -12,26 +14,63 @@ SystemCommands::SystemCommands() {
         FeatureItem("Terminal", "Open terminal", "utilities-terminal", "x-terminal-emulator", "system"),
         FeatureItem("Settings", "Open system settings", "preferences-system", "gnome-control-center", "system")
     };
+
+    QStringList titles;
+    for (const auto& command : m_commands) {
+        titles.append(command.title);
+    }
+    m_titles = FuzzyIndex(titles);
 }
 
-QList<FeatureItem> SystemCommands::search(const QString& query) {
+QList<FeatureItem> SystemCommands::search(const QueryContext& context) {
     QList<FeatureItem> results;
+    const QString& query = context.query;
     if (query.isEmpty()) {
-        return m_commands.mid(0, 6);
+        results = m_commands.mid(0, 6);
+        for (auto& item : results) {
+            item.score = 0.2;
+        }
+        return results;
     }
     
     QList<QPair<FeatureItem, int>> scored;
-    for (const auto& cmd : m_commands) {
-        if (int score = fuzzyMatch(query.toLower(), cmd.title.toLower()); score > 0) {
-            scored.append({cmd, score});
+    QList<int> matched;
+    const FuzzyIndex::Query prepared = FuzzyIndex::prepare(query);
+    const QString& lowerQuery = prepared.folded;
+    QVarLengthArray<int, 32> positions(lowerQuery.size());
+    const auto consider = [&](const int i) {
+        if (!m_titles.mayMatch(i, prepared)) {
+            return;
+        }
+        // same scorer as the apps, "lock" ranks lock screen over the one with l, o, c, k spread out
+        if (const auto score = FuzzyScorer::score(m_commands[i].title, m_titles.text(i), lowerQuery, positions.data())) {
+            scored.append({m_commands[i], *score});
+            if (m_titles.text(i).size() == m_commands[i].title.size()) {
+                scored.last().first.highlights = QList<int>(positions.begin(), positions.end());
+            }
+            matched.append(i);
+        }
+    };
+
+    if (m_candidates.narrows(lowerQuery)) {
+        for (const int i : m_candidates.matches()) {
+            consider(i);
+        }
+    } else {
+        for (int i = 0; i < m_commands.size(); ++i) {
+            consider(i);
         }
     }
+    m_candidates.store(lowerQuery, matched);
     
     std::sort(scored.begin(), scored.end(),
               [](const auto& a, const auto& b) { return a.second > b.second; });
     
+    // a straight prefix of the title is about 1, kept a bit under apps so an app with the same name wins
+    const double prefixScore = FuzzyScorer::prefixScore(lowerQuery.length());
     for (const auto&[fst, snd] : scored) {
         results.append(fst);
+        results.last().score = 0.9 * std::clamp(snd / prefixScore, 0.0, 1.0);
         if (results.size() >= 6) break;
     }
     
@@ -40,19 +79,4 @@ QList<FeatureItem> SystemCommands::search(const QString& query) {
 
 void SystemCommands::execute(const FeatureItem& item) {
     QProcess::startDetached("/bin/sh", {"-c", item.data});
-}
-
-int SystemCommands::fuzzyMatch(const QString& query, const QString& text) {
-    if (query.isEmpty()) return 1;
-    int queryPos = 0;
-    int score = 0;
-    
-    for (int i = 0; i < text.length() && queryPos < query.length(); ++i) {
-        if (text[i] == query[queryPos]) {
-            queryPos++;
-            score += (queryPos == 1) ? 10 : 1;
-        }
-    }
-    
-    return (queryPos == query.length()) ? score : 0;
 }
\ No newline at end of file
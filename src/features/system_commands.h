@@ -1,6 +1,8 @@
 #pragma once
 
 #include "feature_base.h"
+#include "candidate_cache.h"
+#include "fuzzy_index.h"
 #include <QProcess>
 
 class SystemCommands final : public FeatureBase {
@@ -8,10 +10,12 @@ public:
     SystemCommands();
     [[nodiscard]] QString getName() const override { return "System"; }
     [[nodiscard]] QString getIcon() const override { return "system-shutdown"; }
-    QList<FeatureItem> search(const QString& query) override;
+    [[nodiscard]] bool isThreadSafe() const override { return true; }
+    QList<FeatureItem> search(const QueryContext& context) override;
     void execute(const FeatureItem& item) override;
 
 private:
     QList<FeatureItem> m_commands;
-    static int fuzzyMatch(const QString& query, const QString& text);
+    FuzzyIndex m_titles; // same order as m_commands
+    CandidateCache m_candidates;
 };
\ No newline at end of file
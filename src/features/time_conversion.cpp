@@ -3,7 +3,12 @@
 #include <QClipboard>
 #include "time.hpp"
 
-Time::Time() {
+Time::Time()
+    : m_converter(nullptr)
+{
+}
+
+void Time::buildIndex() {
     m_converter = new timelib::TimeConverter();
 }
 
@@ -11,13 +16,17 @@ Time::~Time() {
     delete m_converter;
 }
 
-QList<FeatureItem> Time::search(const QString& query) {
+QList<FeatureItem> Time::search(const QueryContext& context) {
     QList<FeatureItem> results;
-    if (query.trimmed().length() < 5) {
+    const QString& query = context.query;
+    if (query.trimmed().length() < 5 || context.isCancelled()) {
         return results;
     }
 
     const auto parsed_query = m_converter->parseInput(query.toStdString());
+    if (context.isCancelled()) {
+        return results;
+    }
 
     if (const auto res = timelib::TimeConverter::processQuery(parsed_query); res.code == timelib::ErrorCode::Success) {
         const QString resultString = QString::fromStdString(res.result);
@@ -28,11 +37,19 @@ QList<FeatureItem> Time::search(const QString& query) {
             resultString,
             "time"
         ));
+        results.last().score = 1.0;
     }
 
     return results;
 }
 
+FeatureTriggers Time::triggers() const {
+    // timelib needs at least something like "5pm x" to work with
+    FeatureTriggers triggers;
+    triggers.minLength = 5;
+    return triggers;
+}
+
 void Time::execute(const FeatureItem& item) {
     if (QClipboard* clipboard = QApplication::clipboard()) {
         clipboard->setText(item.data);
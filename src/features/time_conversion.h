@@ -13,9 +13,15 @@ public:
 
     [[nodiscard]] QString getName() const override { return "Time"; }
     [[nodiscard]] QString getIcon() const override { return "accessories-clock"; }
-    QList<FeatureItem> search(const QString& query) override;
+    [[nodiscard]] bool isThreadSafe() const override { return true; }
+    [[nodiscard]] bool isCacheable() const override { return false; } // "time in london" changes every minute
+    [[nodiscard]] FeatureTriggers triggers() const override;
+    QList<FeatureItem> search(const QueryContext& context) override;
     void execute(const FeatureItem& item) override;
 
+protected:
+    void buildIndex() override;
+
 private:
     timelib::TimeConverter* m_converter;
 };
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "trigram_index.h"
+#include <QVarLengthArray>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+quint64 trigramAt(const QStringView text, const qsizetype at) {
+    return static_cast<quint64>(text[at].unicode()) << 32 | static_cast<quint64>(text[at + 1].unicode()) << 16 |
+           text[at + 2].unicode();
+}
+
+// query tokens never have spaces in them, trigrams across two words are never looked up
+bool spansWords(const QStringView text, const qsizetype at) {
+    return text[at].isSpace() || text[at + 1].isSpace() || text[at + 2].isSpace();
+}
+
+} // namespace
+
+TrigramIndex::TrigramIndex(const QList<Fields>& documents) {
+    m_offsets.reserve(documents.size() * FIELD_COUNT + 1);
+    QList<std::pair<quint64, int>> pairs;
+    for (qsizetype d = 0; d < documents.size(); ++d) {
+        for (const QString& value : documents[d]) {
+            m_offsets.append(m_text.size());
+            const QString folded = value.toLower();
+            m_text.append(folded);
+            for (qsizetype i = 0; i + 3 <= folded.size(); ++i) {
+                if (!spansWords(folded, i)) {
+                    pairs.append({ trigramAt(folded, i), static_cast<int>(d) });
+                }
+            }
+        }
+    }
+    // the end of the last field
+    m_offsets.append(m_text.size());
+
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    m_postings.reserve(pairs.size());
+    for (const auto& [key, document] : std::as_const(pairs)) {
+        if (m_keys.isEmpty() || m_keys.last() != key) {
+            m_keys.append(key);
+            m_postingStart.append(m_postings.size());
+        }
+        m_postings.append(document);
+    }
+    m_postingStart.append(m_postings.size());
+}
+
+QList<int> TrigramIndex::candidates(const QStringView token) const {
+    if (token.size() < 3) {
+        return {};
+    }
+
+    QVarLengthArray<quint64, 16> keys;
+    for (qsizetype i = 0; i + 3 <= token.size(); ++i) {
+        keys.append(trigramAt(token, i));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    // [begin, end) into m_postings for every trigram, a missing one means no candidates at all
+    QVarLengthArray<std::pair<qsizetype, qsizetype>, 16> lists;
+    for (const quint64 key : keys) {
+        const auto it = std::lower_bound(m_keys.cbegin(), m_keys.cend(), key);
+        if (it == m_keys.cend() || *it != key) {
+            return {};
+        }
+        const qsizetype k = it - m_keys.cbegin();
+        lists.append({ m_postingStart[k], m_postingStart[k + 1] });
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) {
+        return a.second - a.first < b.second - b.first;
+    });
+
+    const int* postings = m_postings.constData();
+    QList<int> result(postings + lists[0].first, postings + lists[0].second);
+    for (qsizetype n = 1; n < lists.size() && !result.isEmpty(); ++n) {
+        result = intersect(result.constData(), result.size(), postings + lists[n].first, lists[n].second - lists[n].first);
+    }
+    return result;
+}
+
+double TrigramIndex::fieldScore(const int document, const QStringView token) const {
+    double best = 0.0;
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        if (WEIGHTS[f] <= best) {
+            continue;
+        }
+        const QStringView text = field(document, static_cast<Field>(f));
+        for (qsizetype at = text.indexOf(token); at >= 0; at = text.indexOf(token, at + 1)) {
+            const bool wordStart = at == 0 || !text[at - 1].isLetterOrNumber();
+            best = std::max(best, WEIGHTS[f] * (wordStart ? 1.0 : INNER_MATCH));
+            if (wordStart) break;
+        }
+    }
+    return best;
+}
+
+QStringView TrigramIndex::field(const int document, const Field field) const {
+    const qsizetype at = static_cast<qsizetype>(document) * FIELD_COUNT + field;
+    return QStringView(m_text).sliced(m_offsets[at], m_offsets[at + 1] - m_offsets[at]);
+}
+
+QList<int> TrigramIndex::intersect(const QList<int>& a, const QList<int>& b) {
+    return intersect(a.constData(), a.size(), b.constData(), b.size());
+}
+
+QList<int> TrigramIndex::intersect(const int* a, const qsizetype aSize, const int* b, const qsizetype bSize) {
+    // walks the shorter one and skips ahead in the longer one by binary search, posting lists of common
+    // trigrams are a lot longer than rare ones
+    if (aSize > bSize) {
+        return intersect(b, bSize, a, aSize);
+    }
+    QList<int> result;
+    const int* from = b;
+    const int* end = b + bSize;
+    for (qsizetype i = 0; i < aSize; ++i) {
+        from = std::lower_bound(from, end, a[i]);
+        if (from == end) {
+            break;
+        }
+        if (*from == a[i]) {
+            result.append(a[i]);
+        }
+    }
+    return result;
+}
\ No newline at end of file
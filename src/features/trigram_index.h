@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringView>
+#include <array>
+
+// inverted index from every 3 char run in a document's fields to the documents that have it. a query
+// token of 3 or more chars can only be a substring of documents that have all of its trigrams, so
+// intersecting those posting lists (shortest first) gives the candidates without looking at any
+// document, and only the candidates get checked for real. postings are one sorted array with the
+// keys and offsets next to it, no per trigram allocation.
+// fields are weighted, a hit in the name counts for more than one in the comment
+class TrigramIndex {
+public:
+    // App is the app a desktop action belongs to, empty for apps themselves
+    enum Field { Name, GenericName, Keywords, Categories, Comment, Binary, App, FIELD_COUNT };
+    using Fields = std::array<QString, FIELD_COUNT>;
+
+    static constexpr std::array<double, FIELD_COUNT> WEIGHTS { 1.0, 0.8, 0.7, 0.5, 0.4, 0.6, 0.8 };
+    // a token found inside a word instead of at its start counts this much of the field's weight
+    static constexpr double INNER_MATCH = 0.6;
+
+    TrigramIndex() = default;
+    // fields get folded here, lists (keywords) can be joined with spaces
+    explicit TrigramIndex(const QList<Fields>& documents);
+
+    [[nodiscard]] qsizetype size() const { return m_offsets.size() / FIELD_COUNT; }
+
+    // ascending ids of the documents that have every trigram of token. token has to be folded and at
+    // least 3 long
+    [[nodiscard]] QList<int> candidates(QStringView token) const;
+    // weight of the best field of document that contains token (folded), 0 if none does
+    [[nodiscard]] double fieldScore(int document, QStringView token) const;
+    [[nodiscard]] QStringView field(int document, Field field) const;
+
+    // both ascending
+    static QList<int> intersect(const QList<int>& a, const QList<int>& b);
+    static QList<int> intersect(const int* a, qsizetype aSize, const int* b, qsizetype bSize);
+
+private:
+    QString m_text; // every field of every document, folded, back to back
+    QList<qsizetype> m_offsets; // field f of document d starts at m_offsets[d * FIELD_COUNT + f]
+    QList<quint64> m_keys; // ascending trigrams
+    QList<qsizetype> m_postingStart; // postings of m_keys[k] are [m_postingStart[k], m_postingStart[k + 1])
+    QList<int> m_postings;
+};
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "typo_matcher.h"
+#include <algorithm>
+
+TypoMatcher::TypoMatcher(const QStringView query)
+    : m_length(std::min(query.size(), MAX_QUERY)) {
+    for (qsizetype i = 0; i < m_length; ++i) {
+        const char16_t c = query[i].unicode();
+        const quint64 bit = 1ULL << i;
+        if (c < m_ascii.size()) {
+            m_ascii[c] |= bit;
+            continue;
+        }
+        const auto it = std::find_if(m_other.begin(), m_other.end(), [c](const auto& entry) { return entry.first == c; });
+        if (it != m_other.end()) {
+            it->second |= bit;
+        } else {
+            m_other.append({ c, bit });
+        }
+    }
+}
+
+quint64 TypoMatcher::patternOf(const char16_t c) const {
+    if (c < m_ascii.size()) {
+        return m_ascii[c];
+    }
+    for (const auto& [other, pattern] : m_other) {
+        if (other == c) return pattern;
+    }
+    return 0;
+}
+
+int TypoMatcher::distance(const QStringView text, const int limit) const {
+    if (m_length == 0) {
+        return 0;
+    }
+
+    // vp/vn: where the current column goes up/down by one from the row above. the top row is all
+    // zeros (the match can start anywhere in text), so nothing carries into bit 0 when shifting
+    const quint64 last = 1ULL << (m_length - 1);
+    quint64 vp = ~0ULL;
+    quint64 vn = 0;
+    quint64 d0 = 0;
+    quint64 previousEq = 0;
+    int score = static_cast<int>(m_length);
+    int best = score;
+    const qsizetype n = text.size();
+    for (qsizetype j = 0; j < n; ++j) {
+        const quint64 eq = patternOf(text[j].unicode());
+        // a swap of query[i - 1], query[i] against text[j - 1], text[j]
+        const quint64 transposed = ((~d0 & eq) << 1) & previousEq;
+        d0 = (((eq & vp) + vp) ^ vp) | eq | vn | transposed;
+        const quint64 hp = vn | ~(d0 | vp);
+        const quint64 hn = d0 & vp;
+        if (hp & last) ++score;
+        if (hn & last) --score;
+        const quint64 x = hp << 1;
+        vn = x & d0;
+        vp = (hn << 1) | ~(x | d0);
+        previousEq = eq;
+
+        best = std::min(best, score);
+        // the bottom row drops by at most one per column
+        if (best > limit && score - (n - j - 1) > limit) {
+            break;
+        }
+    }
+    return std::min(best, limit + 1);
+}
+
+int TypoMatcher::allowedTypos(const qsizetype queryLength) {
+    if (queryLength < 4) return 0;
+    if (queryLength < 8) return 1;
+    return 2;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QList>
+#include <QStringView>
+#include <array>
+#include <utility>
+
+// how many typos a query is from its best spot inside a text: the fewest insertions, deletions,
+// substitutions and swaps of two neighbouring chars (optimal string alignment) that turn the query
+// into some substring of the text. "firfox" is 1 from "mozilla firefox", "thunderbrid" 1 from "thunderbird".
+//
+// myers' bit-parallel edit distance with hyyrö's transposition term: the query is a bit pattern, one
+// column of the dp is a couple of 64 bit words, and each text char costs a dozen ALU ops whatever the
+// query length. queries over 64 chars are cut to their first 64
+class TypoMatcher {
+public:
+    static constexpr qsizetype MAX_QUERY = 64;
+
+    // query has to be folded already
+    explicit TypoMatcher(QStringView query);
+
+    [[nodiscard]] qsizetype length() const { return m_length; }
+    // text has to be folded already. stops early once limit cant be reached anymore, anything over
+    // limit comes back as limit + 1
+    [[nodiscard]] int distance(QStringView text, int limit) const;
+
+    // typos a query of this length may have and still count as a match, 0 means too short to guess
+    static int allowedTypos(qsizetype queryLength);
+
+private:
+    [[nodiscard]] quint64 patternOf(char16_t c) const;
+
+    qsizetype m_length { 0 };
+    std::array<quint64, 128> m_ascii {}; // bit i set where query[i] is that char
+    QList<std::pair<char16_t, quint64>> m_other; // the same for the rare non-ascii chars
+};
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "latency_stats.h"
+#include <QList>
+#include <QtAlgorithms>
+#include <algorithm>
+
+LatencyStats& LatencyStats::instance() {
+    static LatencyStats stats;
+    return stats;
+}
+
+void LatencyStats::record(const QString& span, const qint64 nanoseconds) {
+    const int bucket = bucketFor(nanoseconds);
+    QMutexLocker locker(&m_mutex);
+    Histogram& histogram = m_spans[span];
+    histogram.buckets[bucket]++;
+    histogram.count++;
+    histogram.max = std::max(histogram.max, nanoseconds);
+}
+
+void LatencyStats::markHotkey() {
+    QMutexLocker locker(&m_mutex);
+    m_hotkey.start();
+}
+
+qint64 LatencyStats::markFrame() {
+    qint64 elapsed;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_hotkey.isValid()) {
+            return -1;
+        }
+        elapsed = m_hotkey.nsecsElapsed();
+        m_hotkey.invalidate();
+    }
+    record("hotkey/first frame", elapsed);
+    return elapsed;
+}
+
+QString LatencyStats::report() const {
+    struct Row {
+        QString span;
+        quint64 count;
+        qint64 p50, p95, p99, max;
+    };
+
+    QList<Row> rows;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_spans.constBegin(); it != m_spans.constEnd(); ++it) {
+            const Histogram& histogram = it.value();
+            rows.append({ it.key(), histogram.count, percentile(histogram, 0.50), percentile(histogram, 0.95),
+                          percentile(histogram, 0.99), histogram.max });
+        }
+    }
+
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.p99 > b.p99; });
+
+    QString report = QString("%1 %2 %3 %4 %5 %6\n")
+        .arg(QString("span"), -28)
+        .arg(QString("count"), 7)
+        .arg(QString("p50"), 9)
+        .arg(QString("p95"), 9)
+        .arg(QString("p99"), 9)
+        .arg(QString("max"), 9);
+    for (const Row& row : rows) {
+        report += QString("%1 %2 %3 %4 %5 %6\n")
+            .arg(row.span, -28)
+            .arg(row.count, 7)
+            .arg(formatDuration(row.p50), 9)
+            .arg(formatDuration(row.p95), 9)
+            .arg(formatDuration(row.p99), 9)
+            .arg(formatDuration(row.max), 9);
+    }
+    return report;
+}
+
+void LatencyStats::reset() {
+    QMutexLocker locker(&m_mutex);
+    m_spans.clear();
+    m_hotkey.invalidate();
+}
+
+int LatencyStats::bucketFor(const qint64 nanoseconds) {
+    const auto value = static_cast<quint64>(std::max<qint64>(nanoseconds, 0));
+    if (value < SUB_BUCKETS) {
+        return static_cast<int>(value);
+    }
+
+    // the top bit picks the power of two, the 3 bits under it pick the sub bucket
+    const int magnitude = 63 - qCountLeadingZeroBits(value);
+    const int sub = static_cast<int>((value >> (magnitude - 3)) & (SUB_BUCKETS - 1));
+    return std::min((magnitude - 2) * SUB_BUCKETS + sub, BUCKETS - 1);
+}
+
+qint64 LatencyStats::bucketUpperBound(const int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+
+    const int magnitude = bucket / SUB_BUCKETS + 2;
+    const qint64 sub = bucket % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (magnitude - 3)) - 1;
+}
+
+qint64 LatencyStats::percentile(const Histogram& histogram, const double fraction) {
+    if (histogram.count == 0) {
+        return 0;
+    }
+
+    const auto rank = static_cast<quint64>(fraction * static_cast<double>(histogram.count - 1)) + 1;
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+        seen += histogram.buckets[bucket];
+        if (seen >= rank) {
+            // a bucket's bound can overshoot what was actually recorded
+            return std::min(bucketUpperBound(bucket), histogram.max);
+        }
+    }
+    return histogram.max;
+}
+
+QString LatencyStats::formatDuration(const qint64 nanoseconds) {
+    if (nanoseconds < 1000) {
+        return QString("%1ns").arg(nanoseconds);
+    }
+    if (nanoseconds < 1000 * 1000) {
+        return QString("%1us").arg(static_cast<double>(nanoseconds) / 1e3, 0, 'f', 1);
+    }
+    return QString("%1ms").arg(static_cast<double>(nanoseconds) / 1e6, 0, 'f', 2);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <array>
+
+// collects how long the hot paths take (feature searches, model rebuilds, row painting,
+// hotkey to first frame) into per span histograms. recording is a lock and a bucket increment,
+// so it stays on all the time. read it back with report(), from the debug overlay or --latency-stats
+class LatencyStats {
+public:
+    static LatencyStats& instance();
+
+    void record(const QString& span, qint64 nanoseconds);
+
+    // hotkey to first frame spans two places, the hotkey handler starts it and the first paint after ends it
+    void markHotkey();
+    // returns the hotkey to frame time in ns, -1 if no hotkey was pending
+    qint64 markFrame();
+
+    // one line per span with count, p50/p95/p99 and max, slowest p99 first
+    [[nodiscard]] QString report() const;
+    void reset();
+
+private:
+    // log-linear buckets, 8 per power of two, so percentiles are within ~12%. tops out around half an hour
+    static constexpr int SUB_BUCKETS = 8;
+    static constexpr int BUCKETS = 40 * SUB_BUCKETS;
+
+    struct Histogram {
+        std::array<quint32, BUCKETS> buckets {};
+        quint64 count { 0 };
+        qint64 max { 0 };
+    };
+
+    LatencyStats() = default;
+
+    static int bucketFor(qint64 nanoseconds);
+    static qint64 bucketUpperBound(int bucket);
+    static qint64 percentile(const Histogram& histogram, double fraction);
+    static QString formatDuration(qint64 nanoseconds);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Histogram> m_spans;
+    QElapsedTimer m_hotkey;
+};
+
+// times its own lifetime into a LatencyStats span
+class LatencySpan {
+public:
+    explicit LatencySpan(const QString& span) : m_span(span) { m_timer.start(); }
+    ~LatencySpan() { LatencyStats::instance().record(m_span, m_timer.nsecsElapsed()); }
+
+    LatencySpan(const LatencySpan&) = delete;
+    LatencySpan& operator=(const LatencySpan&) = delete;
+
+private:
+    QString m_span;
+    QElapsedTimer m_timer;
+};
\ No newline at end of file
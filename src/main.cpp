@@ -5,9 +5,11 @@
 #include <QAction>
 #include <QMessageBox>
 #include <QDebug>
+#include <QCommandLineParser>
 #include <X11/keysym.h>
 #include "mainwindow.h"
 #include "globalhotkey.h"
+#include "latency_stats.h"
 
 int main(int argc, char *argv[]) {
     const QApplication app(argc, argv);
@@ -17,6 +19,21 @@ int main(int argc, char *argv[]) {
     app.setOrganizationName("unium");
     app.setOrganizationDomain("unium.in");
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    const QCommandLineOption latencyStatsOption("latency-stats", "Print per-feature latency percentiles on exit.");
+    parser.addOption(latencyStatsOption);
+    const QCommandLineOption instantShowOption("instant-show", "Keep the window pre-rendered while hidden so it shows on the first frame.");
+    parser.addOption(instantShowOption);
+    parser.process(app);
+
+    if (parser.isSet(latencyStatsOption)) {
+        QObject::connect(&app, &QApplication::aboutToQuit, []() {
+            qInfo().noquote() << LatencyStats::instance().report();
+        });
+    }
+
     if (!QSystemTrayIcon::isSystemTrayAvailable()) {
         QMessageBox::critical(nullptr, "rnux", "system tray is not available on this system. how?");
         return -1;
@@ -25,6 +42,7 @@ int main(int argc, char *argv[]) {
     app.setQuitOnLastWindowClosed(false);
 
     MainWindow window;
+    window.setInstantShow(parser.isSet(instantShowOption));
     QSystemTrayIcon trayIcon;
     trayIcon.setIcon(QIcon(":/icon.png"));
     trayIcon.setToolTip("[rnux] Press Alt+Space to activate");
@@ -49,6 +67,8 @@ int main(int argc, char *argv[]) {
         if (window.isVisible()) {
             window.hide();
         } else {
+            LatencyStats::instance().markHotkey();
+            window.beginTypeAhead();
             window.show();
             window.raise();
             window.activateWindow();
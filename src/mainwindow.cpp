@@ -5,13 +5,22 @@
 #include "features/search.h"
 #include "features/time_conversion.h"
 #include "features/clipboard.h"
+#include "latency_stats.h"
 #include <QApplication>
 #include <QGuiApplication>
+#include <QDebug>
+#include <queue>
+#include <vector>
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
     , m_ui(nullptr)
-    , m_searchTimer(nullptr)
+    , m_dispatcher(nullptr)
+    , m_typeAhead(nullptr)
+    , m_submitTimeout(nullptr)
+    , m_submitGeneration(0)
+    , m_shownGeneration(0)
+    , m_instantShow(false)
 {
     setupWindow();
     setupFeatures();
@@ -19,6 +28,8 @@ MainWindow::MainWindow(QWidget* parent)
 }
 
 MainWindow::~MainWindow() {
+    // workers may still be inside a feature's search
+    m_dispatcher->shutdown();
     for (const auto* feature : m_features) {
         delete feature;
     }
@@ -31,26 +42,56 @@ void MainWindow::setupWindow() {
     setAttribute(Qt::WA_TranslucentBackground);
     setStyleSheet("QMainWindow { background-color: transparent; }");
 
-    m_searchTimer = new QTimer(this);
-    m_searchTimer->setSingleShot(true);
-    m_searchTimer->setInterval(50);
+    m_dispatcher = new QueryDispatcher(this);
+    m_typeAhead = new TypeAhead(this);
 
     connect(m_ui, &WindowUI::queryChanged, this, &MainWindow::onQueryChanged);
     connect(m_ui, &WindowUI::itemActivated, this, &MainWindow::onItemActivated);
-    connect(m_searchTimer, &QTimer::timeout, this, &MainWindow::performSearch);
+    connect(m_dispatcher, &QueryDispatcher::resultsChanged, this, &MainWindow::onResultsChanged);
+    m_submitTimeout = new QTimer(this);
+    m_submitTimeout->setSingleShot(true);
+    m_submitTimeout->setInterval(TYPEAHEAD_SUBMIT_TIMEOUT_MS);
+    connect(m_submitTimeout, &QTimer::timeout, this, &MainWindow::activateSubmitted);
+    connect(m_typeAhead, &TypeAhead::submitted, this, [this]() {
+        // deliver() has just replayed the query, whatever it dispatched is what enter was meant for.
+        // if replaying changed nothing, that query's rows can already be up
+        m_submitGeneration = m_dispatcher->generation();
+        if (m_shownGeneration == m_submitGeneration && !m_currentResults.isEmpty()) {
+            activateSubmitted();
+            return;
+        }
+        m_submitTimeout->start();
+    });
 }
 
 void MainWindow::setupFeatures() {
-    const auto searchFeature = new Search();
-    m_features.append(searchFeature);
-    connect(searchFeature, &Search::resultsUpdated, this, &MainWindow::performSearch);
-
-    m_features.append(new AppLauncher());
+    m_features.append(new Search());
+    m_features.append(new AppLauncher(&m_usage));
     m_features.append(new Calculator());
     m_features.append(new SystemCommands());
     m_features.append(new Time());
     m_features.append(new Clipboard());
+    m_dispatcher->setFeatures(m_features);
     updateResults();
+
+    // the features start out empty, their indexes get built once the event loop (and the tray icon) is up
+    connect(m_dispatcher, &QueryDispatcher::featureReady, this, [](const FeatureBase* feature) {
+        qDebug() << "features ~" << feature->getName() << "ready";
+    });
+    QTimer::singleShot(0, m_dispatcher, &QueryDispatcher::initializeFeatures);
+}
+
+void MainWindow::setInstantShow(const bool instant) {
+    m_instantShow = instant;
+    m_ui->setInstantShow(instant);
+    if (instant) {
+        winId(); // creates the native window now instead of on the first show
+        centerWindow();
+    }
+}
+
+void MainWindow::beginTypeAhead() {
+    m_typeAhead->begin(m_ui->getSearchEdit());
 }
 
 void MainWindow::centerWindow() {
@@ -63,27 +104,87 @@ void MainWindow::centerWindow() {
 }
 
 void MainWindow::updateResults() {
+    m_dispatcher->dispatch(m_currentQuery);
+}
+
+void MainWindow::onResultsChanged() {
+    LatencySpan span("ui/merge");
     m_currentResults.clear();
 
-    for (auto* feature : m_features) {
-        if (feature->isEnabled()) {
-            auto results = feature->search(m_currentQuery);
-            for (auto& result : results) {
-                if (result.type != "time") {
-                    result.type = feature->getName();
-                }
-                m_currentResults.append(ResultWithFeature(result, feature));
+    // bounded top-k over every feature's slice, with frequently/recently used items nudged up.
+    // ties keep feature order, then the feature's own order
+    struct Ranked {
+        double score;
+        int order;
+        int slice;
+        int index;
+    };
+    const auto ranksBefore = [](const Ranked& a, const Ranked& b) {
+        return a.score > b.score || (a.score == b.score && a.order < b.order);
+    };
+    // top of the heap is the worst result kept so far
+    std::priority_queue<Ranked, std::vector<Ranked>, decltype(ranksBefore)> best(ranksBefore);
+
+    const auto slices = m_dispatcher->results();
+    int order = 0;
+    for (int s = 0; s < slices.size(); ++s) {
+        const QString name = slices[s].first->getName();
+        const QList<FeatureItem>& results = slices[s].second;
+        for (int i = 0; i < results.size(); ++i) {
+            const double score = results[i].score + USAGE_WEIGHT * m_usage.boost(name, results[i]);
+            const Ranked candidate { score, order++, s, i };
+            if (static_cast<int>(best.size()) < MAX_RESULTS) {
+                best.push(candidate);
+            } else if (ranksBefore(candidate, best.top())) {
+                best.pop();
+                best.push(candidate);
             }
         }
     }
 
+    std::vector<Ranked> ranked;
+    ranked.reserve(best.size());
+    while (!best.empty()) {
+        ranked.push_back(best.top());
+        best.pop();
+    }
+
+    for (auto it = ranked.rbegin(); it != ranked.rend(); ++it) {
+        FeatureBase* feature = slices[it->slice].first;
+        FeatureItem result = slices[it->slice].second[it->index];
+        if (result.type != "time") {
+            result.type = feature->getName();
+        }
+        m_currentResults.append(ResultWithFeature(result, feature));
+    }
+
     QList<FeatureItem> uiResults;
     for (const auto& resultWithFeature : m_currentResults) {
         uiResults.append(resultWithFeature.item);
     }
 
-    m_ui->setResults(uiResults);
+    m_ui->setResults(uiResults, m_dispatcher->generation());
     adjustSize();
+    if (m_instantShow && !isVisible()) {
+        centerWindow();
+    }
+
+    // the dispatcher only hands out slices of the newest query, so any row here is at or past the one
+    // a typed-ahead enter is waiting for
+    if (!m_currentResults.isEmpty()) {
+        m_shownGeneration = m_dispatcher->generation();
+        if (m_submitGeneration != 0) {
+            activateSubmitted();
+        }
+    }
+}
+
+void MainWindow::activateSubmitted() {
+    m_submitGeneration = 0;
+    m_submitTimeout->stop();
+    if (isVisible()) {
+        m_ui->activateCurrentItem();
+    }
 }
 
 void MainWindow::keyPressEvent(QKeyEvent* event) {
@@ -111,42 +212,46 @@ void MainWindow::showEvent(QShowEvent* event) {
     QMainWindow::showEvent(event);
     m_ui->getSearchEdit()->setFocus();
     m_ui->getSearchEdit()->selectAll();
-    centerWindow();
+    // in instant mode it was already centered while hidden, moving it now would cost a frame
+    if (!m_instantShow) {
+        centerWindow();
+    }
 }
 
 void MainWindow::hideEvent(QHideEvent* event) {
     QMainWindow::hideEvent(event);
+    m_submitGeneration = 0;
+    m_submitTimeout->stop();
     m_ui->getSearchEdit()->clear();
     m_currentQuery.clear();
     updateResults();
 }
 
+void MainWindow::changeEvent(QEvent* event) {
+    QMainWindow::changeEvent(event);
+    // focus is finally ours, hand over whatever was typed on the way here
+    if (event->type() == QEvent::ActivationChange && isActiveWindow()) {
+        m_typeAhead->deliver();
+    }
+}
+
 void MainWindow::closeEvent(QCloseEvent* event) {
     event->ignore();
     hide();
 }
 
 void MainWindow::onQueryChanged(const QString& query) {
+    // every keystroke goes straight through, the dispatcher decides which features wait for a pause
     m_currentQuery = query;
-    if (m_searchTimer->isActive()) {
-        m_searchTimer->stop();
-    }
-
-    if (query.trimmed().isEmpty()) {
-        performSearch();
-        return;
-    }
-
-    m_searchTimer->start();
-}
-
-void MainWindow::performSearch() {
     updateResults();
 }
 
 void MainWindow::onItemActivated(const int index) {
     if (index >= 0 && index < m_currentResults.size()) {
         const auto& resultWithFeature = m_currentResults[index];
+        m_usage.record(resultWithFeature.feature->getName(), resultWithFeature.item);
+        // memoized slices were ordered with the old usage
+        m_dispatcher->invalidateMemo();
         resultWithFeature.feature->execute(resultWithFeature.item);
         hide();
     }
@@ -4,6 +4,9 @@
 #include <QCloseEvent>
 
 #include "windowui.h"
+#include "query_dispatcher.h"
+#include "usage_store.h"
+#include "typeahead.h"
 #include "features/feature_base.h"
 
 struct ResultWithFeature {
@@ -19,26 +22,49 @@ public:
     explicit MainWindow(QWidget* parent = nullptr);
     ~MainWindow() override;
 
+    // keeps the native window realized, centered and holding the empty-query results while hidden,
+    // so showing it is just a map with nothing left to lay out or animate
+    void setInstantShow(bool instant);
+    // call from the hotkey right before showing, keys typed until the window has focus get replayed into it
+    void beginTypeAhead();
+
 protected:
     void keyPressEvent(QKeyEvent* event) override;
     void showEvent(QShowEvent* event) override;
     void hideEvent(QHideEvent* event) override;
     void closeEvent(QCloseEvent* event) override;
+    void changeEvent(QEvent* event) override;
 
 private slots:
     void onQueryChanged(const QString& query);
     void onItemActivated(int index);
-    void performSearch();
+    void onResultsChanged();
 
 private:
     void setupFeatures();
     void setupWindow();
     void centerWindow();
     void updateResults();
+    // runs the enter that was typed ahead, once
+    void activateSubmitted();
 
     WindowUI* m_ui;
-    QTimer* m_searchTimer;
+    QueryDispatcher* m_dispatcher;
+    TypeAhead* m_typeAhead;
+    QTimer* m_submitTimeout;
+    quint64 m_submitGeneration; // query generation a typed-ahead enter is waiting on results for, 0 if none
+    quint64 m_shownGeneration; // generation of the rows on screen
+    UsageStore m_usage;
     QList<FeatureBase*> m_features;
     QList<ResultWithFeature> m_currentResults;
     QString m_currentQuery;
+    bool m_instantShow;
+
+    // only this many rows are ever handed to the ui, the best ones across all features
+    static constexpr int MAX_RESULTS = 24;
+    // how much a well used item can climb over a better text match
+    static constexpr double USAGE_WEIGHT = 0.15;
+    // a typed-ahead enter activates with the first results of the replayed query. if none come (nothing
+    // matched) it gives up waiting after this, a debounced feature can take up to DEBOUNCE_MAX_MS
+    static constexpr int TYPEAHEAD_SUBMIT_TIMEOUT_MS = QueryDispatcher::DEBOUNCE_MAX_MS + 200;
 };
\ No newline at end of file
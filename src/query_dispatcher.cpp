@@ -0,0 +1,357 @@
+#include "query_dispatcher.h"
+#include "latency_stats.h"
+#include <QThread>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QDebug>
+#include <QtAlgorithms>
+#include <algorithm>
+
+QueryDispatcher::QueryDispatcher(QObject* parent)
+    : QObject(parent)
+    , m_pool(new QThreadPool(this))
+    , m_frameTimer(new QTimer(this))
+    , m_memo(MEMO_ENTRIES)
+    , m_keystrokeIntervalMs(120.0)
+    , m_latestGeneration(std::make_shared<std::atomic<quint64>>(0))
+{
+    m_pool->setMaxThreadCount(std::max(2, QThread::idealThreadCount()));
+
+    m_frameTimer->setSingleShot(true);
+    connect(m_frameTimer, &QTimer::timeout, this, [this]() {
+        m_lastFrame.start();
+        emit resultsChanged();
+    });
+}
+
+QueryDispatcher::~QueryDispatcher() {
+    shutdown();
+}
+
+void QueryDispatcher::setFeatures(const QList<FeatureBase*>& features) {
+    m_features = features;
+    m_router.setFeatures(m_features);
+    for (const auto& state : std::as_const(m_states)) {
+        delete state.debounce;
+    }
+    m_states.clear();
+
+    // [budgets] Name=ms, keyed by getName()
+    const QSettings budgets(QStandardPaths::writableLocation(QStandardPaths::HomeLocation) + "/.rnux/budgets.ini", QSettings::IniFormat);
+    for (auto* feature : m_features) {
+        FeatureState state;
+        state.budgetMs = budgets.value("budgets/" + feature->getName(), feature->latencyBudgetMs()).toInt();
+        state.debounce = new QTimer(this);
+        state.debounce->setSingleShot(true);
+        connect(state.debounce, &QTimer::timeout, this, [this, feature]() { runDebounced(feature); });
+        m_states.insert(feature, state);
+
+        feature->setResultPublisher([this, feature](const QueryContext& context, const QList<FeatureItem>& results) {
+            QMetaObject::invokeMethod(this, [this, feature, context, results]() {
+                onFeaturePublished(feature, context, results);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void QueryDispatcher::initializeFeatures() {
+    for (auto* feature : m_features) {
+        if (feature->isReady()) {
+            continue;
+        }
+
+        m_pool->start([this, feature]() {
+            QElapsedTimer timer;
+            timer.start();
+            feature->initialize();
+            LatencyStats::instance().record("startup/" + feature->getName(), timer.nsecsElapsed());
+            QMetaObject::invokeMethod(this, [this, feature]() { onFeatureReady(feature); }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void QueryDispatcher::onFeatureReady(FeatureBase* feature) {
+    if (!m_states.contains(feature)) {
+        return;
+    }
+
+    emit featureReady(feature);
+    // something may already be typed, catch up on it
+    if (m_routed.contains(feature)) {
+        runDebounced(feature);
+    }
+}
+
+void QueryDispatcher::dispatch(const QString& query) {
+    noteKeystroke();
+
+    // bumping the shared generation cancels every context handed out so far
+    m_context = QueryContext();
+    m_context.query = query;
+    m_context.generation = m_latestGeneration->fetch_add(1, std::memory_order_relaxed) + 1;
+    m_context.latestGeneration = m_latestGeneration;
+    m_routed = m_router.route(m_context);
+
+    // queue the worker pool first so slow features overlap with the inline ones
+    QList<FeatureBase*> inlineFeatures;
+    for (auto* feature : m_features) {
+        FeatureState& state = m_states[feature];
+        if (!feature->isEnabled() || !feature->isReady() || !m_routed.contains(feature)) {
+            state.debounce->stop();
+            setSlice(feature, {});
+            continue;
+        }
+
+        if (serveFromMemo(feature)) {
+            state.debounce->stop();
+            continue;
+        }
+
+        // the empty query is what the window opens with, nothing to wait for there.
+        // until it fires, the feature's slice from the last query is stale and left out of results()
+        if (!query.isEmpty() && !isCheap(feature)) {
+            state.debounce->start(debounceFor(feature));
+            if (!state.results.isEmpty()) {
+                scheduleFrame();
+            }
+            continue;
+        }
+
+        state.debounce->stop();
+        if (feature->isThreadSafe()) {
+            // a feature only ever has one search in flight, whatever is newest gets picked up once it finishes
+            if (!state.running) {
+                runFeature(feature);
+            }
+        } else {
+            inlineFeatures.append(feature);
+        }
+    }
+
+    const QueryContext context = m_context;
+    for (auto* feature : inlineFeatures) {
+        runInline(feature, m_router.contextFor(feature, context));
+    }
+}
+
+void QueryDispatcher::runInline(FeatureBase* feature, const QueryContext& context) {
+    const quint64 dataVersion = feature->dataVersion();
+    qint64 costNs = -1;
+    const QList<FeatureItem> results = timedSearch(feature, context, costNs);
+    onFeatureFinished(feature, context, dataVersion, results, costNs);
+}
+
+void QueryDispatcher::runDebounced(FeatureBase* feature) {
+    if (!feature->isEnabled() || !feature->isReady() || !m_routed.contains(feature) || serveFromMemo(feature)) {
+        return;
+    }
+
+    if (!feature->isThreadSafe()) {
+        runInline(feature, m_router.contextFor(feature, m_context));
+    } else if (!m_states[feature].running) {
+        runFeature(feature);
+    }
+}
+
+bool QueryDispatcher::isCheap(const FeatureBase* feature) const {
+    if (feature->isNetworked() || isDemoted(feature)) {
+        return false;
+    }
+
+    // never measured yet, the first search finds out
+    const FeatureState& state = *m_states.constFind(feature);
+    return !state.measured || state.costMs < CHEAP_COST_MS;
+}
+
+bool QueryDispatcher::isDemoted(const FeatureBase* feature) const {
+    return !m_states.constFind(feature)->demotedUntil.hasExpired();
+}
+
+int QueryDispatcher::debounceFor(const FeatureBase* feature) const {
+    if (isDemoted(feature)) {
+        return DEBOUNCE_MAX_MS;
+    }
+
+    // wait out a usual gap between keystrokes, a fast typist then only pays for the pauses.
+    // a feature slower than that waits at least as long as it takes, it would be stale by then anyway
+    const double wait = std::max(m_keystrokeIntervalMs * 1.25, m_states.constFind(feature)->costMs);
+    const int floor = feature->isNetworked() ? NETWORK_DEBOUNCE_MIN_MS : DEBOUNCE_MIN_MS;
+    return std::clamp(static_cast<int>(wait), floor, DEBOUNCE_MAX_MS);
+}
+
+void QueryDispatcher::noteKeystroke() {
+    // pauses over a second are the user thinking, not how fast they type
+    if (m_lastKeystroke.isValid()) {
+        if (const qint64 gap = m_lastKeystroke.elapsed(); gap < 1000) {
+            m_keystrokeIntervalMs = 0.7 * m_keystrokeIntervalMs + 0.3 * static_cast<double>(gap);
+        }
+    }
+    m_lastKeystroke.start();
+}
+
+bool QueryDispatcher::serveFromMemo(FeatureBase* feature) {
+    if (!feature->isCacheable()) {
+        return false;
+    }
+
+    const QList<FeatureItem>* cached = m_memo.object(memoKey(feature, m_context.query, feature->dataVersion()));
+    if (!cached) {
+        return false;
+    }
+
+    setSlice(feature, *cached);
+    return true;
+}
+
+void QueryDispatcher::runFeature(FeatureBase* feature) {
+    FeatureState& state = m_states[feature];
+    state.running = true;
+
+    m_pool->start([this, feature, context = m_router.contextFor(feature, m_context)]() {
+        // read before searching, if the data changes halfway the results get memoized as already stale
+        const quint64 dataVersion = feature->dataVersion();
+        // no point starting on a keystroke that is already stale
+        qint64 costNs = -1;
+        const QList<FeatureItem> results = context.isCancelled() ? QList<FeatureItem>() : timedSearch(feature, context, costNs);
+        QMetaObject::invokeMethod(this, [this, feature, context, dataVersion, results, costNs]() {
+            onFeatureFinished(feature, context, dataVersion, results, costNs);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void QueryDispatcher::onFeatureFinished(FeatureBase* feature, const QueryContext& context, const quint64 dataVersion,
+                                        const QList<FeatureItem>& results, const qint64 costNs) {
+    if (!m_states.contains(feature)) {
+        return;
+    }
+
+    FeatureState& state = m_states[feature];
+    if (feature->isThreadSafe()) {
+        state.running = false;
+    }
+
+    const bool inBudget = checkBudget(feature, costNs);
+
+    if (context.generation != m_context.generation) {
+        // the user kept typing while this was running, start over with the newest query.
+        // unless it's debounced, then the timer picks it up
+        if (feature->isThreadSafe() && feature->isEnabled() && m_routed.contains(feature) &&
+            !state.debounce->isActive() && !serveFromMemo(feature)) {
+            runFeature(feature);
+        }
+        return;
+    }
+
+    // memoized even when over budget, they're still right if the query comes back
+    if (feature->isCacheable()) {
+        m_memo.insert(memoKey(feature, context.query, dataVersion), new QList<FeatureItem>(results));
+    }
+    // whatever the previous keystroke left in the slice is stale by now too
+    setSlice(feature, inBudget ? results : QList<FeatureItem>());
+}
+
+bool QueryDispatcher::checkBudget(FeatureBase* feature, const qint64 costNs) {
+    if (costNs < 0) {
+        return true;
+    }
+
+    FeatureState& state = m_states[feature];
+    const double costMs = static_cast<double>(costNs) / 1e6;
+    state.costMs = state.measured ? 0.7 * state.costMs + 0.3 * costMs : costMs;
+    state.measured = true;
+
+    // a budget of 0 or less turns the watchdog off for the feature
+    const bool overran = state.budgetMs > 0 && costMs > state.budgetMs;
+    state.overrunHistory = static_cast<quint8>((state.overrunHistory << 1) | (overran ? 1 : 0));
+    if (!overran) {
+        return true;
+    }
+
+    LatencyStats::instance().record("overrun/" + feature->getName(), costNs);
+    // demoted features only run on pauses, there is nothing newer their results would be in the way of
+    if (isDemoted(feature)) {
+        return true;
+    }
+
+    if (qPopulationCount(state.overrunHistory) >= DEMOTE_AFTER_OVERRUNS) {
+        state.demotedUntil = QDeadlineTimer(DEMOTION_MS);
+        state.overrunHistory = 0;
+        qWarning() << "dispatcher ~" << feature->getName() << "went over its" << state.budgetMs << "ms budget"
+                   << DEMOTE_AFTER_OVERRUNS << "times, only running it on pauses for the next" << DEMOTION_MS / 1000 << "s";
+    }
+    return false;
+}
+
+void QueryDispatcher::onFeaturePublished(FeatureBase* feature, const QueryContext& context, const QList<FeatureItem>& results) {
+    if (!m_states.contains(feature) || context.generation != m_context.generation || !feature->isEnabled()) {
+        return;
+    }
+
+    // a streamed update replaces whatever was memoized for the query
+    if (feature->isCacheable()) {
+        m_memo.insert(memoKey(feature, context.query, feature->dataVersion()), new QList<FeatureItem>(results));
+    }
+    setSlice(feature, results);
+}
+
+void QueryDispatcher::setSlice(FeatureBase* feature, const QList<FeatureItem>& results) {
+    FeatureState& state = m_states[feature];
+    if (state.results == results && state.generation == m_context.generation) {
+        return;
+    }
+
+    state.results = results;
+    state.generation = m_context.generation;
+    scheduleFrame();
+}
+
+QList<FeatureItem> QueryDispatcher::timedSearch(FeatureBase* feature, const QueryContext& context, qint64& costNs) {
+    QElapsedTimer timer;
+    timer.start();
+    QList<FeatureItem> results = feature->search(context);
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    LatencyStats::instance().record("search/" + feature->getName(), elapsed);
+    costNs = context.isCancelled() ? -1 : elapsed;
+    return results;
+}
+
+QString QueryDispatcher::memoKey(const FeatureBase* feature, const QString& query, const quint64 dataVersion) {
+    return feature->getName() + QChar(0x1f) + QString::number(dataVersion) + QChar(0x1f) + query;
+}
+
+void QueryDispatcher::scheduleFrame() {
+    if (m_frameTimer->isActive()) {
+        return;
+    }
+
+    const qint64 sinceLastFrame = m_lastFrame.isValid() ? m_lastFrame.elapsed() : FRAME_INTERVAL_MS;
+    m_frameTimer->start(static_cast<int>(std::max<qint64>(0, FRAME_INTERVAL_MS - sinceLastFrame)));
+}
+
+QList<QPair<FeatureBase*, QList<FeatureItem>>> QueryDispatcher::results() const {
+    QList<QPair<FeatureBase*, QList<FeatureItem>>> slices;
+    for (auto* feature : m_features) {
+        if (const auto it = m_states.constFind(feature);
+            it != m_states.constEnd() && !it->results.isEmpty() && it->generation == m_context.generation) {
+            slices.append({ feature, it->results });
+        }
+    }
+    return slices;
+}
+
+void QueryDispatcher::shutdown() {
+    m_latestGeneration->fetch_add(1, std::memory_order_relaxed);
+    m_pool->waitForDone();
+    m_frameTimer->stop();
+    for (auto* feature : m_features) {
+        feature->setResultPublisher(nullptr);
+    }
+    for (const auto& state : std::as_const(m_states)) {
+        delete state.debounce;
+    }
+    m_features.clear();
+    m_routed.clear();
+    m_states.clear();
+    m_memo.clear();
+}
\ No newline at end of file
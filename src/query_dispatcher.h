@@ -0,0 +1,106 @@
+#pragma once
+
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QCache>
+#include <QDeadlineTimer>
+
+#include "trigger_router.h"
+#include "features/feature_base.h"
+
+// runs the search of every enabled feature the router picks for a query, thread safe features on a worker pool and
+// the rest inline on the gui thread. results are merged per feature as they come in and
+// resultsChanged is emitted at most once per frame. features can keep streaming results for a
+// query after search() returned, those only replace that feature's slice. anything that comes
+// back for an older generation than the current one is dropped.
+// results are also memoized per (query, feature, data version) in a small lru, so backspacing and
+// retyping a query doesn't recompute anything.
+// features that have been cheap lately run on every keystroke. expensive and networked ones are
+// debounced, by about the user's usual gap between keystrokes, so they only run when typing pauses.
+// every search also has a time budget. results that come in over it are dropped for that keystroke
+// (still memoized), and a feature that keeps overrunning gets demoted to running on pauses only for a while.
+// overruns show up as overrun/<feature> in LatencyStats
+class QueryDispatcher final : public QObject {
+    Q_OBJECT
+
+public:
+    explicit QueryDispatcher(QObject* parent = nullptr);
+    ~QueryDispatcher() override;
+
+    void setFeatures(const QList<FeatureBase*>& features);
+    // builds every feature's index on the worker pool, features only get queries once they're ready
+    void initializeFeatures();
+    void dispatch(const QString& query);
+    void shutdown();
+    // drops every memoized result, for when something outside the features' data (like usage) changes their order
+    void invalidateMemo() { m_memo.clear(); }
+
+    // per feature result slices for the current query, in feature order. a slice still left over from an
+    // earlier query (a debounced feature that hasn't run yet) isn't in there, it would rank stale rows
+    [[nodiscard]] QList<QPair<FeatureBase*, QList<FeatureItem>>> results() const;
+    [[nodiscard]] quint64 generation() const { return m_context.generation; }
+
+    static constexpr int FRAME_INTERVAL_MS = 16;
+    static constexpr int MEMO_ENTRIES = 256;
+    // a feature whose recent searches average under this runs on every keystroke
+    static constexpr double CHEAP_COST_MS = 4.0;
+    static constexpr int DEBOUNCE_MIN_MS = 30;
+    static constexpr int NETWORK_DEBOUNCE_MIN_MS = 120;
+    static constexpr int DEBOUNCE_MAX_MS = 300;
+    // demoted once this many of the last 8 searches went over budget
+    static constexpr int DEMOTE_AFTER_OVERRUNS = 3;
+    static constexpr int DEMOTION_MS = 30000;
+
+signals:
+    void resultsChanged();
+    void featureReady(FeatureBase* feature);
+
+private:
+    struct FeatureState {
+        QList<FeatureItem> results;
+        quint64 generation { 0 }; // of the query results came from
+        bool running { false };
+        double costMs { 0.0 }; // moving average of recent searches
+        bool measured { false };
+        QTimer* debounce { nullptr };
+        int budgetMs { 0 };
+        quint8 overrunHistory { 0 }; // one bit per recent search, newest in the lowest bit
+        QDeadlineTimer demotedUntil { QDeadlineTimer(0) };
+    };
+
+    void runFeature(FeatureBase* feature);
+    void runInline(FeatureBase* feature, const QueryContext& context);
+    void runDebounced(FeatureBase* feature);
+    void onFeatureReady(FeatureBase* feature);
+    [[nodiscard]] bool isCheap(const FeatureBase* feature) const;
+    [[nodiscard]] bool isDemoted(const FeatureBase* feature) const;
+    // records the search's cost, returns false if the results are too late to show
+    bool checkBudget(FeatureBase* feature, qint64 costNs);
+    [[nodiscard]] int debounceFor(const FeatureBase* feature) const;
+    void noteKeystroke();
+    bool serveFromMemo(FeatureBase* feature);
+    void onFeatureFinished(FeatureBase* feature, const QueryContext& context, quint64 dataVersion, const QList<FeatureItem>& results, qint64 costNs);
+    void onFeaturePublished(FeatureBase* feature, const QueryContext& context, const QList<FeatureItem>& results);
+    void setSlice(FeatureBase* feature, const QList<FeatureItem>& results);
+    void scheduleFrame();
+
+    // costNs is left at -1 when the search was cancelled, those timings say nothing about the feature
+    static QList<FeatureItem> timedSearch(FeatureBase* feature, const QueryContext& context, qint64& costNs);
+    static QString memoKey(const FeatureBase* feature, const QString& query, quint64 dataVersion);
+
+    QThreadPool* m_pool;
+    QTimer* m_frameTimer;
+    QElapsedTimer m_lastFrame;
+    QList<FeatureBase*> m_features;
+    QHash<FeatureBase*, FeatureState> m_states;
+    QCache<QString, QList<FeatureItem>> m_memo;
+    TriggerRouter m_router;
+    QList<FeatureBase*> m_routed;
+    QueryContext m_context;
+    QElapsedTimer m_lastKeystroke;
+    double m_keystrokeIntervalMs;
+    std::shared_ptr<std::atomic<quint64>> m_latestGeneration;
+};
\ No newline at end of file
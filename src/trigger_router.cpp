@@ -0,0 +1,126 @@
+#include "trigger_router.h"
+#include <algorithm>
+
+void TriggerRouter::setFeatures(const QList<FeatureBase*>& features) {
+    m_features = features;
+    m_nodes = { Node() };
+    m_triggers.clear();
+
+    for (auto* feature : m_features) {
+        FeatureTriggers triggers = feature->triggers();
+        for (const QString& prefix : triggers.prefixes) {
+            insert(prefix.toLower(), feature);
+        }
+        m_triggers.insert(feature, triggers);
+    }
+}
+
+void TriggerRouter::insert(const QString& prefix, FeatureBase* feature) {
+    if (prefix.isEmpty()) {
+        return;
+    }
+
+    int node = 0;
+    for (const QChar c : prefix) {
+        if (const auto it = m_nodes[node].children.constFind(c); it != m_nodes[node].children.constEnd()) {
+            node = *it;
+        } else {
+            m_nodes.append(Node());
+            const int child = static_cast<int>(m_nodes.size()) - 1;
+            m_nodes[node].children.insert(c, child);
+            node = child;
+        }
+    }
+
+    if (!m_nodes[node].owners.contains(feature)) {
+        m_nodes[node].owners.append(feature);
+    }
+}
+
+int TriggerRouter::find(const QStringView word) const {
+    int node = 0;
+    for (const QChar c : word) {
+        const auto it = m_nodes[node].children.constFind(c.toLower());
+        if (it == m_nodes[node].children.constEnd()) {
+            return -1;
+        }
+        node = *it;
+    }
+    return node;
+}
+
+QList<FeatureBase*> TriggerRouter::route(QueryContext& context) const {
+    const QString& query = context.query;
+
+    // walk the first word down the trie
+    qsizetype i = query.indexOf(' ');
+    if (i < 0) {
+        i = query.size();
+    }
+    const int node = find(QStringView(query).left(i));
+
+    const Node* match = node > 0 && !m_nodes[node].owners.isEmpty() ? &m_nodes[node] : nullptr;
+    QList<FeatureBase*> routed;
+
+    if (match && i < query.size()) {
+        // "gh foo" is still a query like any other for the apps ("docker desktop", "wiki"), unless an
+        // owner keeps its prefix to itself like "clip foo"
+        context.trigger = query.left(i).toLower();
+        context.argument = query.mid(i + 1);
+        const bool exclusive = std::any_of(match->owners.cbegin(), match->owners.cend(), [this](const FeatureBase* owner) {
+            return m_triggers[owner].exclusive;
+        });
+        for (auto* feature : m_features) {
+            if (match->owners.contains(feature)) {
+                routed.append(feature);
+            } else if (!exclusive && !m_triggers[feature].prefixOnly && accepts(feature, query)) {
+                routed.append(feature);
+            }
+        }
+        return routed;
+    }
+
+    if (match) {
+        context.trigger = query.toLower();
+    }
+
+    for (auto* feature : m_features) {
+        const FeatureTriggers& triggers = m_triggers[feature];
+        if (match && match->owners.contains(feature)) {
+            if (triggers.matchesBarePrefix) {
+                routed.append(feature);
+            }
+            continue;
+        }
+
+        if (!triggers.prefixOnly && accepts(feature, query)) {
+            routed.append(feature);
+        }
+    }
+    return routed;
+}
+
+QueryContext TriggerRouter::contextFor(const FeatureBase* feature, const QueryContext& context) const {
+    if (context.trigger.isEmpty()) {
+        return context;
+    }
+    if (const int node = find(context.trigger); node > 0 && m_nodes[node].owners.contains(feature)) {
+        return context;
+    }
+
+    QueryContext general = context;
+    general.trigger.clear();
+    general.argument.clear();
+    return general;
+}
+
+bool TriggerRouter::accepts(const FeatureBase* feature, const QString& query) const {
+    const FeatureTriggers& triggers = m_triggers[feature];
+    if (query.trimmed().length() < triggers.minLength) {
+        return false;
+    }
+    if (!triggers.shape.pattern().isEmpty() && !triggers.shape.match(query).hasMatch()) {
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
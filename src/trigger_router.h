@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+
+#include "features/feature_base.h"
+
+// decides which features see a query. the features' trigger prefixes go into a trie, so the first
+// word of a query is looked up in one walk instead of every feature checking its own aliases.
+// "gh foo" reaches the trigger's owners and, like a query without a trigger, every general feature
+// whose length and shape rules accept it. "clip foo" only reaches the clipboard, its prefix is exclusive
+class TriggerRouter {
+public:
+    void setFeatures(const QList<FeatureBase*>& features);
+
+    // features that should run for context.query, in feature order. fills in context.trigger and
+    // context.argument when the query starts with a trigger
+    [[nodiscard]] QList<FeatureBase*> route(QueryContext& context) const;
+    // context as feature should see it, without the trigger and argument if feature doesnt own the trigger
+    [[nodiscard]] QueryContext contextFor(const FeatureBase* feature, const QueryContext& context) const;
+
+private:
+    struct Node {
+        QHash<QChar, int> children;
+        QList<FeatureBase*> owners;
+    };
+
+    void insert(const QString& prefix, FeatureBase* feature);
+    // node the word ends at, -1 if it isnt in the trie
+    [[nodiscard]] int find(QStringView word) const;
+    [[nodiscard]] bool accepts(const FeatureBase* feature, const QString& query) const;
+
+    QList<Node> m_nodes; // m_nodes[0] is the root
+    QList<FeatureBase*> m_features;
+    QHash<const FeatureBase*, FeatureTriggers> m_triggers;
+};
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "typeahead.h"
+#include <QApplication>
+#include <QDebug>
+#include <QKeyEvent>
+#include <utility>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <xcb/xcb.h>
+
+// xlib's KeyPress/KeyRelease macros collide with QEvent's
+static constexpr int X11_KEY_PRESS = KeyPress;
+#undef KeyPress
+#undef KeyRelease
+
+TypeAhead::TypeAhead(QObject* parent)
+    : QObject(parent)
+    , m_display(nullptr)
+    , m_inputMethod(nullptr)
+    , m_inputContext(nullptr)
+    , m_root(0)
+    , m_grabbed(false)
+{
+    if (const auto* x11App = qApp->nativeInterface<QNativeInterface::QX11Application>(); x11App && x11App->display()) {
+        m_display = x11App->display();
+        const auto display = static_cast<Display*>(m_display);
+        m_root = DefaultRootWindow(display);
+
+        // xlib's own input method, not whatever XMODIFIERS points at: it needs no server, and it's only
+        // there to turn key presses into utf-8 for the current layout and to do dead keys/compose
+        XSetLocaleModifiers("@im=none");
+        if (const XIM inputMethod = XOpenIM(display, nullptr, nullptr, nullptr)) {
+            m_inputMethod = inputMethod;
+            m_inputContext = XCreateIC(inputMethod, XNInputStyle, XIMPreeditNothing | XIMStatusNothing,
+                                       XNClientWindow, m_root, XNFocusWindow, m_root, nullptr);
+        }
+        XSetLocaleModifiers("");
+        if (!m_inputContext) {
+            qWarning() << "typeahead ~ no x input context, only latin-1 keys can be typed ahead";
+        }
+
+        QApplication::instance()->installNativeEventFilter(this);
+    }
+
+    m_timeout.setSingleShot(true);
+    m_timeout.setInterval(GRAB_TIMEOUT_MS);
+    connect(&m_timeout, &QTimer::timeout, this, &TypeAhead::deliver);
+}
+
+TypeAhead::~TypeAhead() {
+    release();
+    if (m_inputContext) {
+        XDestroyIC(static_cast<XIC>(m_inputContext));
+    }
+    if (m_inputMethod) {
+        XCloseIM(static_cast<XIM>(m_inputMethod));
+    }
+}
+
+void TypeAhead::begin(QWidget* target) {
+    if (!m_display) {
+        return;
+    }
+
+    m_target = target;
+    m_buffer.clear();
+
+    // the hotkey's passive grab is still active here, this turns it into one that outlives the key release
+    const auto display = static_cast<Display*>(m_display);
+    if (XGrabKeyboard(display, m_root, False, GrabModeAsync, GrabModeAsync, CurrentTime) != GrabSuccess) {
+        qWarning() << "typeahead ~ could not grab the keyboard, keys typed before focus will be lost";
+        return;
+    }
+    XFlush(display);
+    m_grabbed = true;
+    m_timeout.start();
+}
+
+void TypeAhead::deliver() {
+    if (!m_grabbed) {
+        return;
+    }
+    release();
+
+    const QList<BufferedKey> buffer = std::exchange(m_buffer, {});
+    if (!m_target) {
+        return;
+    }
+
+    for (const BufferedKey& buffered : buffer) {
+        if (buffered.key == Qt::Key_Return) {
+            // the results for what was just replayed aren't in yet, whoever listens decides when to activate
+            emit submitted();
+            return;
+        }
+
+        // sent to the search field, anything it ignores (escape, up/down) goes on to the window like a real key
+        QKeyEvent keyDown(QEvent::KeyPress, buffered.key, buffered.modifiers, buffered.scanCode, buffered.keysym,
+                          buffered.state, buffered.text);
+        QApplication::sendEvent(m_target, &keyDown);
+        QKeyEvent keyUp(QEvent::KeyRelease, buffered.key, buffered.modifiers, buffered.scanCode, buffered.keysym,
+                        buffered.state, buffered.text);
+        QApplication::sendEvent(m_target, &keyUp);
+    }
+}
+
+void TypeAhead::release() {
+    m_timeout.stop();
+    if (!m_grabbed) {
+        return;
+    }
+
+    const auto display = static_cast<Display*>(m_display);
+    XUngrabKeyboard(display, CurrentTime);
+    XFlush(display);
+    m_grabbed = false;
+}
+
+bool TypeAhead::nativeEventFilter(const QByteArray& eventType, void* message, qintptr* result) {
+    Q_UNUSED(result)
+
+    if (!m_grabbed || eventType != "xcb_generic_event_t") {
+        return false;
+    }
+
+    const auto event = static_cast<xcb_generic_event_t*>(message);
+    if ((event->response_type & ~0x80) != XCB_KEY_PRESS) {
+        return false;
+    }
+
+    const auto keyEvent = reinterpret_cast<xcb_key_press_event_t*>(event);
+    XEvent xevent {};
+    XKeyEvent& xkey = xevent.xkey;
+    xkey.type = X11_KEY_PRESS;
+    xkey.display = static_cast<Display*>(m_display);
+    xkey.window = keyEvent->event;
+    xkey.root = keyEvent->root;
+    xkey.time = keyEvent->time;
+    xkey.state = keyEvent->state;
+    xkey.keycode = keyEvent->detail;
+    xkey.same_screen = keyEvent->same_screen;
+
+    // a dead key is swallowed by the input context, the key that completes it brings the composed text
+    if (m_inputContext && XFilterEvent(&xevent, None)) {
+        return true;
+    }
+
+    KeySym keysym = NoSymbol;
+    QString text;
+    if (m_inputContext) {
+        const auto context = static_cast<XIC>(m_inputContext);
+        QByteArray buffer(32, Qt::Uninitialized);
+        Status status = XLookupNone;
+        int length = Xutf8LookupString(context, &xkey, buffer.data(), static_cast<int>(buffer.size()), &keysym, &status);
+        if (status == XBufferOverflow) {
+            buffer.resize(length);
+            length = Xutf8LookupString(context, &xkey, buffer.data(), static_cast<int>(buffer.size()), &keysym, &status);
+        }
+        if (status == XLookupChars || status == XLookupBoth) {
+            text = QString::fromUtf8(buffer.constData(), length);
+        }
+    } else {
+        char buffer[32];
+        const int length = XLookupString(&xkey, buffer, sizeof(buffer), &keysym, nullptr);
+        text = QString::fromLatin1(buffer, length);
+    }
+    // shift and friends only change the keys after them, their state is already in those
+    if (IsModifierKey(keysym)) {
+        return true;
+    }
+
+    Qt::KeyboardModifiers modifiers;
+    if (keyEvent->state & ShiftMask) modifiers |= Qt::ShiftModifier;
+    if (keyEvent->state & ControlMask) modifiers |= Qt::ControlModifier;
+    if (keyEvent->state & Mod1Mask) modifiers |= Qt::AltModifier;
+    if (keyEvent->state & Mod4Mask) modifiers |= Qt::MetaModifier;
+
+    // the grab means x already gave this key to us and no one else, so everything is kept: chords
+    // (ctrl+backspace, ctrl+a) and keys without text go to the window like any other. the hotkey never
+    // gets here, GlobalHotkey's filter is installed later and so runs first
+    m_buffer.append({ qtKeyOf(keysym, text), modifiers, text, keyEvent->detail, static_cast<quint32>(keysym), keyEvent->state });
+    return true;
+}
+
+int TypeAhead::qtKeyOf(const unsigned long keysym, const QString& text) {
+    if (keysym >= XK_F1 && keysym <= XK_F35) {
+        return Qt::Key_F1 + static_cast<int>(keysym - XK_F1);
+    }
+
+    switch (keysym) {
+    case XK_BackSpace: return Qt::Key_Backspace;
+    case XK_Delete:
+    case XK_KP_Delete: return Qt::Key_Delete;
+    case XK_Return:
+    case XK_KP_Enter: return Qt::Key_Return;
+    case XK_Escape: return Qt::Key_Escape;
+    case XK_Tab: return Qt::Key_Tab;
+    case XK_ISO_Left_Tab: return Qt::Key_Backtab;
+    case XK_Up:
+    case XK_KP_Up: return Qt::Key_Up;
+    case XK_Down:
+    case XK_KP_Down: return Qt::Key_Down;
+    case XK_Left:
+    case XK_KP_Left: return Qt::Key_Left;
+    case XK_Right:
+    case XK_KP_Right: return Qt::Key_Right;
+    case XK_Home:
+    case XK_KP_Home: return Qt::Key_Home;
+    case XK_End:
+    case XK_KP_End: return Qt::Key_End;
+    case XK_Page_Up:
+    case XK_KP_Page_Up: return Qt::Key_PageUp;
+    case XK_Page_Down:
+    case XK_KP_Page_Down: return Qt::Key_PageDown;
+    case XK_Insert:
+    case XK_KP_Insert: return Qt::Key_Insert;
+    case XK_Menu: return Qt::Key_Menu;
+    default: break;
+    }
+
+    // latin-1 keysyms are their own code point, that still works when ctrl turned the text into a
+    // control char ("a" under ctrl is \x01)
+    if (keysym >= 0x20 && keysym <= 0xff) {
+        return QChar(static_cast<char16_t>(keysym)).toUpper().unicode();
+    }
+    if (!text.isEmpty() && text.at(0).isPrint()) {
+        return text.at(0).toUpper().unicode();
+    }
+    // media keys and such, still replayed, with the native keysym for whatever wants it
+    return Qt::Key_unknown;
+}
\ No newline at end of file
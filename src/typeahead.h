@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QAbstractNativeEventFilter>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+
+// keeps what gets typed between the hotkey and the search field getting focus. begin() grabs the
+// x keyboard, key presses are picked out of the native event stream while the window maps and
+// activates, and deliver() lets go of the grab and replays them into the target in order.
+// keys are turned into text through an x input context, so any layout (and dead keys) come out as
+// utf-8. under the grab x sends every key to us and nobody else, so chords and keys without text are
+// kept too and replayed with their modifiers, the window sees them as if it had focus all along
+class TypeAhead final : public QObject, public QAbstractNativeEventFilter {
+    Q_OBJECT
+
+public:
+    explicit TypeAhead(QObject* parent = nullptr);
+    ~TypeAhead() override;
+
+    void begin(QWidget* target);
+    void deliver();
+
+    // how long the keyboard stays grabbed if the window never gets focus
+    static constexpr int GRAB_TIMEOUT_MS = 1000;
+
+signals:
+    // enter was typed ahead, whatever is replayed after it is dropped
+    void submitted();
+
+protected:
+    bool nativeEventFilter(const QByteArray& eventType, void* message, qintptr* result) override;
+
+private:
+    struct BufferedKey {
+        int key;
+        Qt::KeyboardModifiers modifiers;
+        QString text;
+        quint32 scanCode; // the x keycode, keysym and state, for anything that looks past key()
+        quint32 keysym;
+        quint32 state;
+    };
+
+    // Qt::Key_* for keysym, Key_unknown if there is none
+    static int qtKeyOf(unsigned long keysym, const QString& text);
+
+    void release();
+
+    void* m_display;
+    void* m_inputMethod; // XIM and XIC, kept void so xlib's macros stay out of this header
+    void* m_inputContext;
+    unsigned long m_root;
+    bool m_grabbed;
+    QList<BufferedKey> m_buffer;
+    QPointer<QWidget> m_target;
+    QTimer m_timeout;
+};
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "usage_store.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+UsageStore::UsageStore()
+    : m_file(QStandardPaths::writableLocation(QStandardPaths::HomeLocation) + "/.rnux/usage.bin")
+{
+    open();
+}
+
+UsageStore::~UsageStore() {
+    if (m_data && m_fallback.isEmpty()) {
+        m_file.unmap(m_data);
+    }
+}
+
+void UsageStore::open() {
+    QDir().mkpath(QFileInfo(m_file.fileName()).absolutePath());
+
+    if (m_file.open(QIODevice::ReadWrite)) {
+        const bool fresh = m_file.size() != FILE_SIZE;
+        if (fresh) {
+            m_file.resize(FILE_SIZE);
+            m_file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+        }
+
+        if ((m_data = m_file.map(0, FILE_SIZE))) {
+            if (fresh || std::memcmp(header()->magic, "RNXU", 4) != 0 ||
+                header()->version != VERSION || header()->capacity != CAPACITY) {
+                reset();
+            }
+            return;
+        }
+        m_file.close();
+    }
+
+    qWarning() << "usage ~ could not map" << m_file.fileName() << "launches wont be remembered";
+    m_fallback = QByteArray(FILE_SIZE, 0);
+    m_data = reinterpret_cast<uchar*>(m_fallback.data());
+    reset();
+}
+
+void UsageStore::reset() {
+    std::memset(m_data, 0, FILE_SIZE);
+    std::memcpy(header()->magic, "RNXU", 4);
+    header()->version = VERSION;
+    header()->capacity = CAPACITY;
+    header()->count = 0;
+}
+
+void UsageStore::record(const QString& feature, const FeatureItem& item) {
+    QWriteLocker locker(&m_lock);
+    const quint32 time = now();
+
+    // past 3/4 full the probe chains get long, forget the least used half
+    if (header()->count >= CAPACITY / 4 * 3) {
+        compact(time);
+    }
+
+    const quint64 key = keyFor(feature, item);
+    Record* slots = records();
+    quint32 slot = key % CAPACITY;
+    while (slots[slot].key != 0 && slots[slot].key != key) {
+        slot = (slot + 1) % CAPACITY;
+    }
+
+    Record& record = slots[slot];
+    if (record.key == 0) {
+        record = { key, 0.0f, 0, 0, 0 };
+        header()->count++;
+    }
+    record.score = static_cast<float>(decayed(record, time) + 1.0);
+    record.lastUsed = time;
+    record.uses++;
+}
+
+double UsageStore::frecency(const QString& feature, const FeatureItem& item) const {
+    QReadLocker locker(&m_lock);
+    const Record* record = find(keyFor(feature, item));
+    return record ? decayed(*record, now()) : 0.0;
+}
+
+double UsageStore::boost(const QString& feature, const FeatureItem& item) const {
+    // one use is worth ~0.28, five ~0.8
+    return 1.0 - std::exp(-frecency(feature, item) / 3.0);
+}
+
+const UsageStore::Record* UsageStore::find(const quint64 key) const {
+    const Record* slots = records();
+    quint32 slot = key % CAPACITY;
+    for (quint32 i = 0; i < CAPACITY; ++i) {
+        if (slots[slot].key == key) {
+            return &slots[slot];
+        }
+        if (slots[slot].key == 0) {
+            return nullptr;
+        }
+        slot = (slot + 1) % CAPACITY;
+    }
+    return nullptr;
+}
+
+void UsageStore::compact(const quint32 now) {
+    std::vector<Record> kept;
+    kept.reserve(header()->count);
+    for (quint32 i = 0; i < CAPACITY; ++i) {
+        if (Record record = records()[i]; record.key != 0) {
+            record.score = static_cast<float>(decayed(record, now));
+            record.lastUsed = now;
+            kept.push_back(record);
+        }
+    }
+
+    std::sort(kept.begin(), kept.end(), [](const Record& a, const Record& b) { return a.score > b.score; });
+    kept.resize(std::min<size_t>(kept.size(), CAPACITY / 2));
+
+    reset();
+    Record* slots = records();
+    for (const Record& record : kept) {
+        quint32 slot = record.key % CAPACITY;
+        while (slots[slot].key != 0) {
+            slot = (slot + 1) % CAPACITY;
+        }
+        slots[slot] = record;
+        header()->count++;
+    }
+}
+
+quint64 UsageStore::keyFor(const QString& feature, const FeatureItem& item) {
+    // fnv-1a, it has to stay the same across runs so qHash is out
+    quint64 hash = 14695981039346656037ULL;
+    const auto mix = [&hash](const QString& text) {
+        for (const QChar c : text) {
+            hash = (hash ^ c.unicode()) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0x1f) * 1099511628211ULL;
+    };
+    mix(feature);
+    mix(item.title);
+    mix(item.data);
+    return hash == 0 ? 1 : hash;
+}
+
+double UsageStore::decayed(const Record& record, const quint32 now) {
+    if (record.lastUsed == 0) {
+        return 0.0;
+    }
+    const double elapsed = now > record.lastUsed ? static_cast<double>(now - record.lastUsed) : 0.0;
+    return record.score * std::exp2(-elapsed / (HALF_LIFE_DAYS * 24 * 3600));
+}
+
+quint32 UsageStore::now() {
+    return static_cast<quint32>(QDateTime::currentSecsSinceEpoch());
+}
\ No newline at end of file
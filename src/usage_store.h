@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QFile>
+#include <QReadWriteLock>
+#include <QString>
+
+#include "features/feature_base.h"
+
+// remembers what gets launched/selected, in a small memory mapped hash table (~/.rnux/usage.bin).
+// every use adds 1 to an item's score, and scores halve every HALF_LIFE_DAYS, so things used a lot
+// recently rank above things used a lot a long time ago
+class UsageStore {
+public:
+    UsageStore();
+    ~UsageStore();
+
+    UsageStore(const UsageStore&) = delete;
+    UsageStore& operator=(const UsageStore&) = delete;
+
+    void record(const QString& feature, const FeatureItem& item);
+    // decayed use count, 0 for anything never used
+    [[nodiscard]] double frecency(const QString& feature, const FeatureItem& item) const;
+    // frecency squashed into [0, 1), for mixing into relevance scores
+    [[nodiscard]] double boost(const QString& feature, const FeatureItem& item) const;
+
+    static constexpr quint32 CAPACITY = 4096;
+    static constexpr double HALF_LIFE_DAYS = 7.0;
+
+private:
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 capacity;
+        quint32 count;
+    };
+
+    struct Record {
+        quint64 key; // 0 marks an empty slot
+        float score;
+        quint32 lastUsed; // seconds since epoch
+        quint32 uses;
+        quint32 reserved;
+    };
+
+    static constexpr quint32 VERSION = 1;
+    static constexpr qint64 FILE_SIZE = sizeof(Header) + CAPACITY * sizeof(Record);
+
+    void open();
+    void reset();
+    void compact(quint32 now);
+    [[nodiscard]] Header* header() const { return reinterpret_cast<Header*>(m_data); }
+    [[nodiscard]] Record* records() const { return reinterpret_cast<Record*>(m_data + sizeof(Header)); }
+    [[nodiscard]] const Record* find(quint64 key) const;
+
+    static quint64 keyFor(const QString& feature, const FeatureItem& item);
+    static double decayed(const Record& record, quint32 now);
+    static quint32 now();
+
+    QFile m_file;
+    QByteArray m_fallback; // used when the file cant be mapped, nothing persists then
+    uchar* m_data { nullptr };
+    mutable QReadWriteLock m_lock;
+};
\ No newline at end of file
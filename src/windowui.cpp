@@ -1,7 +1,9 @@
 #include "windowui.h"
+#include "latency_stats.h"
 #include <QPainter>
 #include <QApplication>
 #include <QFontMetrics>
+#include <QTextLayout>
 #include <QLinearGradient>
 #include <QItemSelectionModel>
 #include <QScrollBar>
@@ -15,6 +17,7 @@
 #include <QFileInfo>
 #include <random>
 #include <QRegularExpression>
+#include <QDebug>
 
 ModernItemDelegate::ModernItemDelegate(QObject* parent)
     : QStyledItemDelegate(parent)
@@ -97,6 +100,8 @@ QIcon ModernItemDelegate::loadIcon(const QString& iconName) {
 }
 
 void ModernItemDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const {
+    static const QString spanName("ui/paint row");
+    LatencySpan span(spanName);
     painter->save();
     painter->setRenderHint(QPainter::Antialiasing);
     painter->setRenderHint(QPainter::SmoothPixmapTransform);
@@ -174,7 +179,17 @@ void ModernItemDelegate::paintDefaultItem(QPainter* painter, const QStyleOptionV
     QRect titleRect = rect.adjusted(48, 0, -50, 0);
     QFontMetrics titleMetrics(m_titleFont);
     QString elidedTitle = titleMetrics.elidedText(title, Qt::ElideRight, titleRect.width());
-    painter->drawText(titleRect, Qt::AlignLeft | Qt::AlignVCenter, elidedTitle);
+    if (const auto highlights = index.data(Qt::UserRole + 3).value<QList<int>>(); !highlights.isEmpty()) {
+        // eliding keeps the start of the title, whatever got cut off just isnt marked
+        const qsizetype shown = elidedTitle == title ? title.size() : elidedTitle.size() - 1;
+        QList<int> visible;
+        for (const int at : highlights) {
+            if (at < shown) visible.append(at);
+        }
+        drawHighlightedText(painter, titleRect, elidedTitle, visible, isSelected);
+    } else {
+        painter->drawText(titleRect, Qt::AlignLeft | Qt::AlignVCenter, elidedTitle);
+    }
 
     // type/action indicator text thing
     QString type = index.data(Qt::UserRole + 2).toString();
@@ -194,6 +209,36 @@ void ModernItemDelegate::paintDefaultItem(QPainter* painter, const QStyleOptionV
     }
 }
 
+void ModernItemDelegate::drawHighlightedText(QPainter* painter, const QRect& rect, const QString& text, const QList<int>& highlights, const bool isSelected) const {
+    // runs of adjacent matches become one format range
+    QList<QTextLayout::FormatRange> ranges;
+    for (const int at : highlights) {
+        if (!ranges.isEmpty() && ranges.last().start + ranges.last().length == at) {
+            ++ranges.last().length;
+            continue;
+        }
+        QTextLayout::FormatRange range;
+        range.start = at;
+        range.length = 1;
+        // the selection background is close to the accent, underline there instead
+        if (isSelected) {
+            range.format.setFontUnderline(true);
+        } else {
+            range.format.setForeground(m_accentColor.lighter(170));
+        }
+        ranges.append(range);
+    }
+
+    QTextLayout layout(text, m_titleFont);
+    layout.setFormats(ranges);
+    layout.beginLayout();
+    QTextLine line = layout.createLine();
+    line.setLineWidth(rect.width());
+    layout.endLayout();
+    // same vertical centering drawText with AlignVCenter does
+    layout.draw(painter, QPointF(rect.left(), rect.top() + (rect.height() - line.height()) / 2.0));
+}
+
 void ModernItemDelegate::paintTimeItem(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const {
     QRect rect = option.rect;
     bool isSelected = option.state & QStyle::State_Selected;
@@ -418,10 +463,15 @@ WindowUI::WindowUI(QWidget* parent)
     , m_model(nullptr)
     , m_delegate(nullptr)
     , m_separator(nullptr)
+    , m_statsLabel(nullptr)
+    , m_statsTimer(nullptr)
     , m_heightAnimation(nullptr)
     , m_showAnimation(nullptr)
     , m_opacityEffect(nullptr)
+    , m_shadowEffect(nullptr)
     , m_blurAnimation(nullptr)
+    , m_resultsGeneration(0)
+    , m_instantShow(false)
     , m_currentHeight(SEARCH_HEIGHT)
     , m_hasResults(false)
     , m_backgroundOpacity(0.0)
@@ -490,6 +540,19 @@ void WindowUI::setupUI() {
     m_mainLayout->addWidget(m_listView);
     m_mainLayout->addWidget(m_emptyLabel);
 
+    // hidden unless someone is chasing typing latency
+    m_statsLabel = new QLabel(this);
+    m_statsLabel->setTextFormat(Qt::PlainText);
+    m_statsLabel->setVisible(false);
+    m_mainLayout->addWidget(m_statsLabel);
+
+    m_statsTimer = new QTimer(this);
+    m_statsTimer->setInterval(STATS_REFRESH_MS);
+    connect(m_statsTimer, &QTimer::timeout, this, &WindowUI::refreshStatsOverlay);
+
+    const auto* statsShortcut = new QShortcut(QKeySequence("Ctrl+Shift+L"), this);
+    connect(statsShortcut, &QShortcut::activated, this, &WindowUI::toggleStatsOverlay);
+
     m_heightAnimation = new QPropertyAnimation(this, "minimumHeight", this);
     m_heightAnimation->setDuration(300);
     m_heightAnimation->setEasingCurve(QEasingCurve::OutExpo);
@@ -581,9 +644,26 @@ void WindowUI::setupStyles() const {
         "    padding: 40px 24px;"
         "}"
     );
+
+    m_statsLabel->setStyleSheet(
+        "QLabel {"
+        "    color: #9CA3AF;"
+        "    font-family: 'JetBrains Mono', 'DejaVu Sans Mono', monospace;"
+        "    font-size: 11px;"
+        "    background-color: rgba(255, 255, 255, 0.04);"
+        "    padding: 8px 16px;"
+        "}"
+    );
 }
 
-void WindowUI::setResults(const QList<FeatureItem>& results) {
+void WindowUI::setResults(const QList<FeatureItem>& results, const quint64 generation) {
+    // late results for an older query never replace newer ones
+    if (generation < m_resultsGeneration) {
+        return;
+    }
+
+    LatencySpan span("ui/setResults");
+    m_resultsGeneration = generation;
     m_currentResults = results;
     m_hasResults = !results.isEmpty();
 
@@ -593,6 +673,7 @@ void WindowUI::setResults(const QList<FeatureItem>& results) {
         modelItem->setData(item.subtitle, Qt::UserRole);
         modelItem->setData(item.icon, Qt::UserRole + 1);
         modelItem->setData(item.type, Qt::UserRole + 2);
+        modelItem->setData(QVariant::fromValue(item.highlights), Qt::UserRole + 3);
         modelItem->setFlags(modelItem->flags() & ~Qt::ItemIsEditable);
         m_model->appendRow(modelItem);
     }
@@ -660,6 +741,10 @@ void WindowUI::updateHeight() {
         newHeight += 120;
     }
 
+    if (m_statsLabel->isVisible()) {
+        newHeight += m_statsLabel->sizeHint().height();
+    }
+
     if (newHeight != m_currentHeight) {
         animateHeight(newHeight);
         m_currentHeight = newHeight;
@@ -667,6 +752,14 @@ void WindowUI::updateHeight() {
 }
 
 void WindowUI::animateHeight(const int newHeight) {
+    // nobody sees it while hidden, and it shouldn't still be running when the window comes up
+    if (!isVisible()) {
+        m_heightAnimation->stop();
+        setMinimumHeight(newHeight);
+        setFixedHeight(newHeight);
+        return;
+    }
+
     m_heightAnimation->setStartValue(height());
     m_heightAnimation->setEndValue(newHeight);
     m_heightAnimation->start();
@@ -686,6 +779,10 @@ void WindowUI::updateEmptyState() const {
 
 void WindowUI::showEvent(QShowEvent* event) {
     QWidget::showEvent(event);
+    if (m_instantShow) {
+        m_backgroundOpacity = 1.0;
+        return;
+    }
     animateIn();
 }
 
@@ -695,22 +792,32 @@ void WindowUI::animateIn() const {
 }
 
 void WindowUI::drawBlurredBackground(QPainter* painter, const QRect& rect) const {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> dis(0.0, 1.0);
     painter->save();
     const auto baseColor = QColor(15, 15, 15, static_cast<int>(235 * m_backgroundOpacity));
     painter->fillRect(rect, baseColor);
 
-    for (int i = 0; i < rect.width(); i += 4) {
-        for (int j = 0; j < rect.height(); j += 4) {
-            if (dis(gen) > 0.98) {
-                painter->setPen(QColor(255, 255, 255, static_cast<int>(8 * m_backgroundOpacity)));
-                painter->drawPoint(i, j);
+    // rolling thousands of random points on every repaint was most of the frame, it only changes with the size
+    if (m_noise.size() != rect.size() * devicePixelRatioF()) {
+        static std::random_device rd;
+        static std::mt19937 gen(rd());
+        static std::uniform_real_distribution<> dis(0.0, 1.0);
+
+        m_noise = QPixmap(rect.size() * devicePixelRatioF());
+        m_noise.setDevicePixelRatio(devicePixelRatioF());
+        m_noise.fill(Qt::transparent);
+        QPainter noisePainter(&m_noise);
+        noisePainter.setPen(QColor(255, 255, 255, 8));
+        for (int i = 0; i < rect.width(); i += 4) {
+            for (int j = 0; j < rect.height(); j += 4) {
+                if (dis(gen) > 0.98) {
+                    noisePainter.drawPoint(i, j);
+                }
             }
         }
     }
 
+    painter->setOpacity(m_backgroundOpacity);
+    painter->drawPixmap(rect.topLeft(), m_noise);
     painter->restore();
 }
 
@@ -743,16 +850,46 @@ void WindowUI::paintEvent(QPaintEvent* event) {
     painter.drawPath(path);
 
     QWidget::paintEvent(event);
+    if (const qint64 elapsed = LatencyStats::instance().markFrame(); elapsed >= 0) {
+        const double ms = static_cast<double>(elapsed) / 1e6;
+        if (ms > FIRST_FRAME_TARGET_MS) {
+            qWarning() << "ui ~ hotkey to first frame took" << ms << "ms, target is" << FIRST_FRAME_TARGET_MS << "ms";
+        } else {
+            qDebug() << "ui ~ hotkey to first frame" << ms << "ms";
+        }
+    }
+}
+
+void WindowUI::toggleStatsOverlay() {
+    const bool show = !m_statsLabel->isVisible();
+    m_statsLabel->setVisible(show);
+    if (show) {
+        refreshStatsOverlay();
+        m_statsTimer->start();
+    } else {
+        m_statsTimer->stop();
+        updateHeight();
+    }
+}
+
+void WindowUI::refreshStatsOverlay() {
+    m_statsLabel->setText(LatencyStats::instance().report().trimmed());
+    updateHeight();
 }
 
 void WindowUI::resizeEvent(QResizeEvent* event) {
     QWidget::resizeEvent(event);
 
-    auto* shadow = new QGraphicsDropShadowEffect(this);
-    shadow->setBlurRadius(SHADOW_BLUR);
-    shadow->setColor(QColor(0, 0, 0, 120));
-    shadow->setOffset(0, 12);
-    setGraphicsEffect(shadow);
+    // installed once, swapping in a new effect on every resize threw its cached render away each time
+    if (m_shadowEffect) {
+        return;
+    }
+    m_shadowEffect = new QGraphicsDropShadowEffect(this);
+    m_shadowEffect->setBlurRadius(SHADOW_BLUR);
+    m_shadowEffect->setColor(QColor(0, 0, 0, 120));
+    m_shadowEffect->setOffset(0, 12);
+    setGraphicsEffect(m_shadowEffect); // deletes the opacity effect
+    m_opacityEffect = nullptr;
 }
 
 void WindowUI::onTextChanged(const QString& text) {
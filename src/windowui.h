@@ -14,6 +14,7 @@
 #include <QParallelAnimationGroup>
 #include <QVariantAnimation>
 #include <QIcon>
+#include <QShortcut>
 
 #include "features/feature_base.h"
 
@@ -29,6 +30,8 @@ private:
     void paintDefaultItem(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const;
     void paintTimeItem(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const;
     void paintImageItem(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const;
+    // text with the chars at highlights (the query's matches) picked out, left aligned in rect
+    void drawHighlightedText(QPainter* painter, const QRect& rect, const QString& text, const QList<int>& highlights, bool isSelected) const;
     static QIcon loadIcon(const QString& iconName);
 
     QFont m_titleFont;
@@ -55,7 +58,9 @@ public:
     explicit WindowUI(QWidget* parent = nullptr);
     ~WindowUI() override;
 
-    void setResults(const QList<FeatureItem>& results);
+    void setResults(const QList<FeatureItem>& results, quint64 generation);
+    // skips the intro animation, every frame after show is the finished window
+    void setInstantShow(bool instant) { m_instantShow = instant; }
     void setQuery(const QString& query);
     void selectNextItem() const;
     void selectPreviousItem() const;
@@ -73,6 +78,9 @@ public:
     static constexpr int WINDOW_WIDTH = 680;
     static constexpr int BORDER_RADIUS = 16;
     static constexpr int SHADOW_BLUR = 32;
+    static constexpr int STATS_REFRESH_MS = 500;
+    // hotkey to first frame above this gets logged
+    static constexpr int FIRST_FRAME_TARGET_MS = 16;
 
 signals:
     void itemActivated(int index);
@@ -97,6 +105,8 @@ private:
     void animateIn() const;
     void drawBlurredBackground(QPainter* painter, const QRect& rect) const;
     void drawGlassEffect(QPainter* painter, const QRect& rect) const;
+    void toggleStatsOverlay();
+    void refreshStatsOverlay();
 
     QVBoxLayout* m_mainLayout;
     QFrame* m_searchFrame;
@@ -108,14 +118,20 @@ private:
     QStandardItemModel* m_model;
     ModernItemDelegate* m_delegate;
     QFrame* m_separator;
+    QLabel* m_statsLabel; // latency overlay, ctrl+shift+l
+    QTimer* m_statsTimer;
 
     QPropertyAnimation* m_heightAnimation;
     QParallelAnimationGroup* m_showAnimation;
     QGraphicsOpacityEffect* m_opacityEffect;
+    QGraphicsDropShadowEffect* m_shadowEffect;
     QVariantAnimation* m_blurAnimation;
 
     QList<FeatureItem> m_currentResults;
     QString m_currentQuery;
+    quint64 m_resultsGeneration;
+    mutable QPixmap m_noise; // background speckle, rendered once per size
+    bool m_instantShow;
     int m_currentHeight;
     bool m_hasResults;
     qreal m_backgroundOpacity;